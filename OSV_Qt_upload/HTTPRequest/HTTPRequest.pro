@@ -15,10 +15,12 @@ TEMPLATE = lib
 
 DEFINES += HTTPREQUEST_LIBRARY
 
-SOURCES += httprequest.cpp
+SOURCES += httprequest.cpp \
+    uploadtransport.cpp
 
 HEADERS += httprequest.h\
-        httprequest_global.h
+        httprequest_global.h \
+    uploadtransport.h
 
 unix,mac {
     target.path = /usr/lib
@@ -1,29 +1,120 @@
 #include "httprequest.h"
+#include "uploadtransport.h"
 #include <QStringList>
 #include <QString>
 #include <QCoreApplication>
 #include <QDebug>
 #include <QUrlQuery>
 #include <QHttpMultiPart>
+#include <climits>
+
+// a connection that sends nothing for a minute is taken as lost
+static const int kDefaultStallTimeout = 60000;
+static const int kDefaultDeadline = 60000;
+static const qint64 kDefaultMinimumRate = 8 * 1024;
+
+void ReplyReader::watch(QNetworkReply *reply, QObject *receiver)
+{
+    ReplyReader* reader = new ReplyReader(reply);
+    connect(reader, SIGNAL(uploadProgress(qint64,qint64)), receiver, SLOT(onUploadProgress(qint64,qint64)));
+    connect(reader, SIGNAL(finished(HTTPResponse)), receiver, SLOT(onRequestCompleted(HTTPResponse)));
+    connect(receiver, SIGNAL(abortRequested()), reader, SLOT(abort()));
+}
+
+ReplyReader::ReplyReader(QNetworkReply *reply)
+    : QObject(reply),
+      m_reply(reply)
+{
+    connect(reply, SIGNAL(uploadProgress(qint64,qint64)), this, SIGNAL(uploadProgress(qint64,qint64)));
+    connect(reply, SIGNAL(finished()), this, SLOT(onFinished()));
+}
+
+void ReplyReader::abort()
+{
+    if (!m_reply->isFinished())
+    {
+        m_reply->abort();
+    }
+}
+
+void ReplyReader::onFinished()
+{
+    HTTPResponse response;
+    response.body = m_reply->readAll();
+    response.httpStatus = m_reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    response.error = m_reply->error();
+    response.errorString = m_reply->errorString();
+    emit finished(response);
+    // the multipart and this reader are children of the reply
+    m_reply->deleteLater();
+}
 
 HTTPRequest::HTTPRequest(QObject *parent, QNetworkAccessManager *networkManager)
+    : HTTPRequest(parent, networkManager, nullptr)
+{
+}
+
+HTTPRequest::HTTPRequest(QObject *parent, UploadTransport *transport)
+    : HTTPRequest(parent, nullptr, transport)
+{
+}
+
+HTTPRequest::HTTPRequest(QObject *parent, QNetworkAccessManager *networkManager, UploadTransport *transport)
     : QObject(parent),
-      m_lastBytesSent(0)
+      m_manager(networkManager),
+      m_transport(transport),
+      m_lastBytesSent(0),
+      m_isFinished(false),
+      m_stallTimer(this),
+      m_deadlineTimer(this),
+      m_stallTimeout(kDefaultStallTimeout),
+      m_deadline(kDefaultDeadline),
+      m_minimumRate(kDefaultMinimumRate),
+      m_bodySize(0),
+      m_isTimedOut(false)
 {
-    if (!networkManager) {
+    if (!m_manager && !m_transport) {
         m_manager = new QNetworkAccessManager(this);
     }
-    else {
-        m_manager = networkManager;
-    }
+
+    // the arguments of the queued calls to the shards and of the answers coming back
+    qRegisterMetaType<HTTPResponse>("HTTPResponse");
+    qRegisterMetaType<QNetworkRequest>("QNetworkRequest");
+    qRegisterMetaType<QHttpMultiPart*>("QHttpMultiPart*");
+
+    m_stallTimer.setSingleShot(true);
+    m_deadlineTimer.setSingleShot(true);
+    connect(&m_stallTimer, SIGNAL(timeout()), this, SLOT(onWatchdogTimeout()));
+    connect(&m_deadlineTimer, SIGNAL(timeout()), this, SLOT(onWatchdogTimeout()));
+}
+
+void HTTPRequest::setTimeouts(int stallTimeout, int deadline, qint64 minimumRate)
+{
+    m_stallTimeout = stallTimeout;
+    m_deadline = deadline;
+    m_minimumRate = minimumRate;
+}
+
+bool HTTPRequest::isTimedOut() const
+{
+    return m_isTimedOut;
 }
 
 void HTTPRequest::post(const QString &url, QHttpMultiPart *multipart)
 {
     QNetworkRequest request;
-    QNetworkReply* reply(nullptr);
     request.setUrl(QUrl(url));
+    // the stall clock starts with the first bytes of the body: a request can wait for a connection
+    // in the queue of its manager, only the deadline covers a connection that never opens
+    startWatchdog(request.url());
+
+    if (m_transport)
+    {
+        postOnShard(request, multipart);
+        return;
+    }
 
+    QNetworkReply* reply(nullptr);
     if (multipart)
     {
         reply = m_manager->post(request, multipart);
@@ -34,10 +125,40 @@ void HTTPRequest::post(const QString &url, QHttpMultiPart *multipart)
         QByteArray emptyBody;
         reply = m_manager->post(request, emptyBody);
     }
+    ReplyReader::watch(reply, this);
+}
 
-    connect(reply, SIGNAL(uploadProgress(qint64,qint64)), this, SLOT(onUploadProgress(qint64,qint64)));
-    connect(reply, SIGNAL(finished()), this, SLOT(onRequestCompleted()));
-    connect(reply, SIGNAL(error(QNetworkReply::NetworkError)), this, SLOT(onRequestFailed(QNetworkReply::NetworkError)));
+void HTTPRequest::postOnShard(const QNetworkRequest &request, QHttpMultiPart *multipart)
+{
+    NetworkShard* shard = m_transport->nextShard();
+    if (multipart)
+    {
+        // the body is read on the thread of the shard, its devices go along as children
+        multipart->moveToThread(shard->thread());
+    }
+
+    // blocks until the reader of the reply is connected to this request, no answer is missed
+    if (!QMetaObject::invokeMethod(shard, "post", Qt::BlockingQueuedConnection,
+                                   Q_ARG(QNetworkRequest, request), Q_ARG(QHttpMultiPart*, multipart),
+                                   Q_ARG(QObject*, this)))
+    {
+        if (multipart)
+        {
+            multipart->deleteLater();
+        }
+        failRequest();
+    }
+}
+
+// the handler is called from the event loop, never from inside post() or get()
+void HTTPRequest::failRequest()
+{
+    qDebug() << "Request not started on its network thread: " << m_url.toString();
+    HTTPResponse response;
+    response.error = QNetworkReply::UnknownNetworkError;
+    response.errorString = QStringLiteral("The request could not be started on its network thread");
+    QMetaObject::invokeMethod(this, "onRequestCompleted", Qt::QueuedConnection,
+                              Q_ARG(HTTPResponse, response));
 }
 
 QHttpPart part_parameter(QString key, QString value) {
@@ -60,31 +181,51 @@ void HTTPRequest::get(const QString &url)
 {
     QNetworkRequest request;
     request.setUrl(QUrl(url));
+    startWatchdog(request.url());
 
-    QNetworkReply *reply = m_manager->get(request);
-
-    connect(reply, SIGNAL(finished()), this, SLOT(onRequestCompleted()));
-    connect(reply, SIGNAL(error(QNetworkReply::NetworkError)), this, SLOT(onRequestFailed(QNetworkReply::NetworkError)));
-}
-
-void HTTPRequest::onRequestCompleted() {
-    QNetworkReply* reply = qobject_cast<QNetworkReply*>(sender());
-    if (_handler_func)
+    if (m_transport)
     {
-        _handler_func(reply);
+        if (!QMetaObject::invokeMethod(m_transport->nextShard(), "get",
+                                       Qt::BlockingQueuedConnection,
+                                       Q_ARG(QNetworkRequest, request), Q_ARG(QObject*, this)))
+        {
+            failRequest();
+        }
+        return;
     }
+    ReplyReader::watch(m_manager->get(request), this);
 }
 
-void HTTPRequest::onRequestFailed(QNetworkReply::NetworkError error) {
-    QNetworkReply* reply = qobject_cast<QNetworkReply*>(sender());
+void HTTPRequest::onRequestCompleted(const HTTPResponse &response) {
+    m_isFinished = true;
+    stopWatchdog();
     if (_handler_func)
     {
-        _handler_func(reply);
+        _handler_func(response);
     }
 }
 
 void HTTPRequest::onUploadProgress(qint64 bytesSent, qint64 bytesTotal)
 {
+    if (bytesTotal > 0 && bytesTotal != m_bodySize)
+    {
+        // the size of a multipart body is known once it is being sent
+        m_bodySize = bytesTotal;
+        startDeadline();
+    }
+    if (m_stallTimeout > 0 && bytesSent > m_lastBytesSent)
+    {
+        if (bytesSent < bytesTotal)
+        {
+            m_stallTimer.start(m_stallTimeout);
+        }
+        else
+        {
+            // the body is sent, the server may take its time to answer until the deadline
+            m_stallTimer.stop();
+        }
+    }
+
     if(bytesSent <= 0 || bytesTotal <= 0)
     {
         return;
@@ -96,3 +237,51 @@ void HTTPRequest::onUploadProgress(qint64 bytesSent, qint64 bytesTotal)
         emit newBytesDifference(bytesDiff);
     }
 }
+
+void HTTPRequest::onWatchdogTimeout()
+{
+    if (m_isFinished)
+    {
+        return;
+    }
+
+    qDebug() << (sender() == &m_deadlineTimer ? "Request deadline passed: " : "Request stalled: ")
+             << m_url.toString() << " sent " << m_lastBytesSent << " of " << m_bodySize;
+    m_isTimedOut = true;
+    stopWatchdog();
+    // the reader aborts the reply on its own thread, the failure comes back through
+    // onRequestCompleted, which may delete this request
+    emit abortRequested();
+}
+
+void HTTPRequest::startWatchdog(const QUrl &url)
+{
+    m_url = url;
+    m_isFinished = false;
+    m_bodySize = 0;
+    m_isTimedOut = false;
+    m_elapsedTimer.start();
+    startDeadline();
+}
+
+void HTTPRequest::stopWatchdog()
+{
+    m_stallTimer.stop();
+    m_deadlineTimer.stop();
+}
+
+void HTTPRequest::startDeadline()
+{
+    if (m_deadline <= 0)
+    {
+        return;
+    }
+
+    qint64 deadline = m_deadline;
+    if (m_minimumRate > 0)
+    {
+        deadline += m_bodySize * 1000 / m_minimumRate;
+    }
+    const qint64 remaining = deadline - m_elapsedTimer.elapsed();
+    m_deadlineTimer.start((int)qBound<qint64>(0, remaining, INT_MAX));
+}
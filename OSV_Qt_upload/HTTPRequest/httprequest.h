@@ -2,42 +2,127 @@
 #define HTTPREQUEST_H
 
 #include "httprequest_global.h"
+#include <QByteArray>
+#include <QMetaType>
 #include <QNetworkReply>
 #include <QNetworkRequest>
+#include <QElapsedTimer>
 #include <QObject>
+#include <QString>
+#include <QTimer>
 #include <QUrl>
 #include <QUrlQuery>
 #include <functional>
 
+class UploadTransport;
+
+/*
+ * What a finished reply said, read on the thread of the reply and handed over by value.
+ */
+struct HTTPResponse
+{
+    HTTPResponse()
+        : httpStatus(0)
+        , error(QNetworkReply::NoError)
+    {
+    }
+
+    QByteArray                  body;
+    int                         httpStatus;  // 0 if no HTTP answer came
+    QNetworkReply::NetworkError error;
+    QString                     errorString;
+};
+Q_DECLARE_METATYPE(HTTPResponse)
+
+/*
+ * The only object touching a reply, created on the thread of the reply as its child.
+ * QNetworkReply is reentrant, not thread-safe: the reader forwards the upload progress, reads the
+ * answer into an HTTPResponse once the reply finished and deletes the reply. Other threads reach
+ * the reply through the queued abort() slot only.
+ */
+class HTTPREQUESTSHARED_EXPORT ReplyReader : public QObject
+{
+    Q_OBJECT
+public:
+    // has to run on the thread of 'reply', 'receiver' is connected before the reply can finish
+    static void watch(QNetworkReply* reply, QObject* receiver);
+
+public slots:
+    void abort();
+
+signals:
+    void uploadProgress(qint64 bytesSent, qint64 bytesTotal);
+    void finished(const HTTPResponse& response);
+
+private slots:
+    void onFinished();
+
+private:
+    explicit ReplyReader(QNetworkReply* reply);
+
+    QNetworkReply* m_reply;
+};
+
 class HTTPREQUESTSHARED_EXPORT HTTPRequest : public QObject
 {
     Q_OBJECT
 public:
     explicit HTTPRequest(QObject* parent = 0, QNetworkAccessManager* networkManager = 0);
+    // the request is sent by a shard of 'transport', its reply lives on the thread of the shard
+    HTTPRequest(QObject* parent, UploadTransport* transport);
 
     void post(const QString& url, QHttpMultiPart* multipart = nullptr);
     void post(const QString& url, QMap<QString, QString>& postData);
     void get(const QString& url);
 
-    void setHandlerFunc(std::function<void(QNetworkReply* reply)> handler_func)
+    // runs on the thread of the request, the reply is already deleted
+    void setHandlerFunc(std::function<void(const HTTPResponse& response)> handler_func)
     {
         _handler_func = handler_func;
     }
 
+    // Watchdog of the next request, times in milliseconds, 0 turns a check off.
+    // The reply is aborted if its body is not sent any further for 'stallTimeout' once sending
+    // started, or if it is not finished after 'deadline' plus the time to send the body at
+    // 'minimumRate' bytes per second. The deadline counts from post(), so it also covers a
+    // connection that never opens. The handler then gets QNetworkReply::OperationCanceledError.
+    void setTimeouts(int stallTimeout, int deadline, qint64 minimumRate);
+    bool isTimedOut() const;
+
 signals:
     void newBytesDifference(qint64 bytesDiff);
+    void abortRequested();
 public slots:
 
 private slots:
-    void onRequestCompleted();
-    void onRequestFailed(QNetworkReply::NetworkError error);
+    void onRequestCompleted(const HTTPResponse& response);
     void onUploadProgress(qint64 sentBytes, qint64 totalBytes);
+    void onWatchdogTimeout();
 
 private:
-    std::function<void(QNetworkReply* reply)> _handler_func;
+    HTTPRequest(QObject* parent, QNetworkAccessManager* networkManager, UploadTransport* transport);
+
+    void postOnShard(const QNetworkRequest& request, QHttpMultiPart* multipart);
+    void failRequest();
+    void startWatchdog(const QUrl& url);
+    void stopWatchdog();
+    void startDeadline();
+
+    std::function<void(const HTTPResponse& response)> _handler_func;
 
     QNetworkAccessManager* m_manager;
+    UploadTransport*       m_transport;
     qint64                 m_lastBytesSent;
+    QUrl                   m_url;
+    bool                   m_isFinished;
+    QTimer                 m_stallTimer;
+    QTimer                 m_deadlineTimer;
+    QElapsedTimer          m_elapsedTimer;
+    int                    m_stallTimeout;
+    int                    m_deadline;
+    qint64                 m_minimumRate;
+    qint64                 m_bodySize;
+    bool                   m_isTimedOut;
 };
 
 #endif  // HTTPREQUEST_H
@@ -0,0 +1,93 @@
+#include "uploadtransport.h"
+#include "httprequest.h"
+#include <QThread>
+
+NetworkShard::NetworkShard()
+    : QObject(0),
+      m_manager(new QNetworkAccessManager(this)),
+      m_requestsInFlight(0)
+{
+}
+
+int NetworkShard::requestsInFlight() const
+{
+    return m_requestsInFlight.load();
+}
+
+void NetworkShard::post(const QNetworkRequest& request, QHttpMultiPart* multipart, QObject* receiver)
+{
+    if (!multipart)
+    {
+        // empty Body request
+        watch(m_manager->post(request, QByteArray()), receiver);
+        return;
+    }
+
+    QNetworkReply* reply = m_manager->post(request, multipart);
+    multipart->setParent(reply);
+    watch(reply, receiver);
+}
+
+void NetworkShard::get(const QNetworkRequest& request, QObject* receiver)
+{
+    watch(m_manager->get(request), receiver);
+}
+
+void NetworkShard::watch(QNetworkReply* reply, QObject* receiver)
+{
+    m_requestsInFlight.ref();
+    connect(reply, SIGNAL(finished()), this, SLOT(onReplyFinished()));
+    ReplyReader::watch(reply, receiver);
+}
+
+void NetworkShard::onReplyFinished()
+{
+    m_requestsInFlight.deref();
+}
+
+UploadTransport::UploadTransport(int shardCount, QObject* parent)
+    : QObject(parent)
+{
+    for (int index = 0; index < qMax(1, shardCount); ++index)
+    {
+        QThread*      thread = new QThread(this);
+        NetworkShard* shard  = new NetworkShard();
+        shard->moveToThread(thread);
+        connect(thread, SIGNAL(finished()), shard, SLOT(deleteLater()));
+        thread->start();
+
+        m_threads.append(thread);
+        m_shards.append(shard);
+    }
+}
+
+UploadTransport::~UploadTransport()
+{
+    // the shards are deleted by their threads, with the replies still in flight
+    for (QThread* thread : m_threads)
+    {
+        thread->quit();
+    }
+    for (QThread* thread : m_threads)
+    {
+        thread->wait();
+    }
+}
+
+int UploadTransport::shardCount() const
+{
+    return m_shards.size();
+}
+
+NetworkShard* UploadTransport::nextShard() const
+{
+    NetworkShard* next = m_shards.first();
+    for (NetworkShard* shard : m_shards)
+    {
+        if (shard->requestsInFlight() < next->requestsInFlight())
+        {
+            next = shard;
+        }
+    }
+    return next;
+}
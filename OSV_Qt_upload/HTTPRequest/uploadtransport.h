@@ -0,0 +1,63 @@
+#ifndef UPLOADTRANSPORT_H
+#define UPLOADTRANSPORT_H
+
+#include "httprequest_global.h"
+#include <QAtomicInt>
+#include <QHttpMultiPart>
+#include <QList>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QObject>
+
+class QThread;
+
+/*
+ * One network access manager and the thread it runs on.
+ * Replies are created and read on that thread, only HTTPResponse values and the upload progress
+ * reach the requests, through queued connections.
+ */
+class HTTPREQUESTSHARED_EXPORT NetworkShard : public QObject
+{
+    Q_OBJECT
+public:
+    NetworkShard();
+
+    int requestsInFlight() const;
+
+    // Run on the thread of the shard, 'multipart' has to be moved there before and is owned by the
+    // reply. The reply is watched by a ReplyReader connected to 'receiver', an HTTPRequest.
+    Q_INVOKABLE void post(const QNetworkRequest& request, QHttpMultiPart* multipart, QObject* receiver);
+    Q_INVOKABLE void get(const QNetworkRequest& request, QObject* receiver);
+
+private slots:
+    void onReplyFinished();
+
+private:
+    void watch(QNetworkReply* reply, QObject* receiver);
+
+    QNetworkAccessManager* m_manager;
+    QAtomicInt             m_requestsInFlight;
+};
+
+/*
+ * Spreads requests over several network access managers, each on a thread of its own.
+ * QNetworkAccessManager opens at most six connections to a host, with N shards up to 6 * N uploads
+ * to the same server run at once. A request goes to the shard with the fewest requests in flight.
+ */
+class HTTPREQUESTSHARED_EXPORT UploadTransport : public QObject
+{
+    Q_OBJECT
+public:
+    explicit UploadTransport(int shardCount, QObject* parent = 0);
+    ~UploadTransport();
+
+    int           shardCount() const;
+    NetworkShard* nextShard() const;
+
+private:
+    QList<QThread*>      m_threads;
+    QList<NetworkShard*> m_shards;
+};
+
+#endif  // UPLOADTRANSPORT_H
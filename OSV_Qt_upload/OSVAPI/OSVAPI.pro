@@ -23,7 +23,8 @@ SOURCES += skosvapimanager.cpp \
     metadatainfo.cpp \
     utils.cpp \
     photodetection.cpp \
-    metadataqtwrapper.cpp
+    metadataqtwrapper.cpp \
+    trackstore.cpp
 
 HEADERS += skosvapimanager.h\
         osvapi_global.h \
@@ -37,7 +38,8 @@ HEADERS += skosvapimanager.h\
     metadatainfo.h \
     utils.h \
     photodetection.h \
-    metadataqtwrapper.h
+    metadataqtwrapper.h \
+    trackstore.h
 
 unix,mac {
     target.path = /usr/lib
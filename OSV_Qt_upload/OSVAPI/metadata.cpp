@@ -1,6 +1,7 @@
 #include "metadata.h"
 #include "utils.h"
 #include <QDebug>
+#include <algorithm>
 
 Metadata::Metadata()
 {
@@ -11,25 +12,30 @@ void Metadata::parseMetaData(const std::string &rawMetadata, Metadata &metadata)
 {
 
     std::vector<MetaDataInfo>& returnList = metadata.metadataInfo;
-    std::vector<std::string> newLinesList = Utils::split_string(rawMetadata,"\n");
 
-    std::string version = kVersionInvalid;
+    // lines and fields are parsed in place, nothing of the track is copied
+    StringTokenizer lines(rawMetadata, '\n');
+    StringRef line;
 
-    int i = 0;
-    for(auto str : newLinesList) {
-        if (i == 0) { //meta info
-            std::vector<std::string> splitValues = Utils::split_string(str,";");
-            if(splitValues.size() >= 2) {
+    std::string version = kVersionInvalid;
+    if(lines.next(line)) { //meta info
+        StringTokenizer values(line, ';');
+        StringRef value;
+        int i = 0;
+        while(values.next(value)) {
+            if(i++ == 2) {
                 //we have version
-                version = splitValues.at(2);
+                version = value.toString();
+                break;
             }
         }
-        else {
-            //meta
-            MetaDataInfo metaDataObj(str,version);
-            returnList.push_back(metaDataObj);
-        }
-        i++;
+    }
+
+    const MetaDataInfo::Layout &layout = MetaDataInfo::layoutForVersion(version);
+    returnList.reserve(std::count(rawMetadata.begin(), rawMetadata.end(), '\n'));
+    while(lines.next(line)) {
+        //meta
+        returnList.emplace_back(line, layout);
     }
 
     metadata.meta_version = version;
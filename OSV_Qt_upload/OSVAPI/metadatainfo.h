@@ -1,6 +1,8 @@
 #ifndef METADATAINFO_H
 #define METADATAINFO_H
+#include <string>
 #include <vector>
+#include "utils.h"
 
 #define kVersionInvalid "ios_first_version"
 #define kVersion101 "1.0.1"
@@ -15,7 +17,21 @@
 class MetaDataInfo
 {
 public:
+    typedef double MetaDataInfo::*Field;
+
+    // columns of a track line for one version, resolved once per track instead of once per line
+    struct Layout
+    {
+        const Field *fields;
+        int count;
+    };
+
     MetaDataInfo(const std::string &metaInfo, const std::string &version);
+    // 'metaInfo' is only read while constructing, a line of a larger buffer is not copied
+    MetaDataInfo(const StringRef &metaInfo, const Layout &layout);
+
+    // the layout of an unknown version has no columns
+    static const Layout &layoutForVersion(const std::string &version);
 
     double _timestamp;
     double _longitude;
@@ -44,7 +60,7 @@ public:
     double _OBD2speed;
     bool   _isInterpolated;
 private:
-    void setValueForKey(const double &value, const std::string &key);
+    void parse(const StringRef &metaInfo, const Layout &layout);
 };
 
 #endif // METADATAINFO_H
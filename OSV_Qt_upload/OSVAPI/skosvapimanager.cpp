@@ -43,9 +43,9 @@ QJsonObject objectFromString(const QString& in)
 void SKOSVAPIManager::getEcho(std::function<void (const int revisionNo)> success_function, std::function<void ()> failed_function) {
     HTTPRequest *request = new HTTPRequest(NULL,m_manager);
 
-    request->setHandlerFunc([=] (QNetworkReply *reply) {
-        if (reply) {
-            QByteArray data = reply->readAll();
+    request->setHandlerFunc([=] (const HTTPResponse &response) {
+        if (response.error == QNetworkReply::NoError) {
+            QByteArray data = response.body;
             QString string_data = QString::fromLatin1(data.data());
 
             QJsonObject json = objectFromString(string_data);
@@ -98,9 +98,9 @@ void SKOSVAPIManager::getList(std::function<void (QList<Sequence*> sequences, in
 
     HTTPRequest *request = new HTTPRequest(NULL,m_manager);
 
-    request->setHandlerFunc([=] (QNetworkReply *reply) {
-        if (reply) {
-            QByteArray data = reply->readAll();
+    request->setHandlerFunc([=] (const HTTPResponse &response) {
+        if (response.error == QNetworkReply::NoError) {
+            QByteArray data = response.body;
             QString string_data = QString::fromLatin1(data.data());
 
             QJsonObject json = objectFromString(string_data);
@@ -188,9 +188,9 @@ void SKOSVAPIManager::getPhotoList(std::function<void (QList<Photo*> photos)> su
              const QString &sequenceId) {
     HTTPRequest *request = new HTTPRequest(NULL,m_manager);
 
-    request->setHandlerFunc([=] (QNetworkReply *reply) {
-        if (reply) {
-            QByteArray data = reply->readAll();
+    request->setHandlerFunc([=] (const HTTPResponse &response) {
+        if (response.error == QNetworkReply::NoError) {
+            QByteArray data = response.body;
             QString string_data = QString::fromLatin1(data.data());
 
             QJsonObject json = objectFromString(string_data);
@@ -252,12 +252,12 @@ void SKOSVAPIManager::getPhoto(std::function<void (QImage image)> success_functi
              const QString &path) {
     HTTPRequest *request = new HTTPRequest(NULL,m_manager);
 
-    request->setHandlerFunc([=] (QNetworkReply *reply) {
-        if (reply) {
+    request->setHandlerFunc([=] (const HTTPResponse &response) {
+        if (response.error == QNetworkReply::NoError) {
 
             //to do, error handling, check http error codes
             QImage image;
-            image.loadFromData(reply->readAll());
+            image.loadFromData(response.body);
 
             if (success_function) {
                 success_function(image);
@@ -278,9 +278,9 @@ void SKOSVAPIManager::getMetadata(std::function<void (QByteArray metadata)> succ
              const QString &path) {
     HTTPRequest *request = new HTTPRequest(NULL,m_manager);
 
-    request->setHandlerFunc([=] (QNetworkReply *reply) {
-        if (reply) {
-            QByteArray data = reply->readAll();
+    request->setHandlerFunc([=] (const HTTPResponse &response) {
+        if (response.error == QNetworkReply::NoError) {
+            QByteArray data = response.body;
 
             if (success_function) {
                 success_function(data);
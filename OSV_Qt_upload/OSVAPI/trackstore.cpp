@@ -0,0 +1,276 @@
+#include "trackstore.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include "utils.h"
+
+static const uint32_t kTrackCacheMagic = 0x5456534F; // "OSVT"
+static const uint32_t kTrackCacheVersion = 1;
+static const uint32_t kMaxVersionLength = 256;
+
+template <typename T>
+static void writeValue(std::ofstream &stream, const T &value)
+{
+    stream.write(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+template <typename T>
+static bool readValue(std::ifstream &stream, T &value)
+{
+    return (bool)stream.read(reinterpret_cast<char *>(&value), sizeof(value));
+}
+
+TrackStore::TrackStore()
+    : m_version(kVersionInvalid)
+    , m_layout(MetaDataInfo::layoutForVersion(m_version))
+    , m_defaults(StringRef(), m_layout)
+    , m_size(0)
+{
+    m_columns.resize(m_layout.count);
+}
+
+void TrackStore::parseMetaData(const std::string &rawMetadata, TrackStore &store)
+{
+    store.clear();
+
+    // the new line ending the last row does not start another one
+    StringRef text(rawMetadata);
+    if(!text.empty() && text.data[text.size - 1] == '\n') {
+        text.size--;
+    }
+    StringTokenizer lines(text, '\n');
+    StringRef line;
+
+    std::string version = kVersionInvalid;
+    if(lines.next(line)) { //meta info
+        StringTokenizer values(line, ';');
+        StringRef value;
+        int i = 0;
+        while(values.next(value)) {
+            if(i++ == 2) {
+                version = value.toString();
+                break;
+            }
+        }
+    }
+    store.setVersion(version);
+
+    const size_t rows = std::count(text.begin(), text.end(), '\n');
+    const int columns = store.m_layout.count;
+    for(int j = 0; j < columns; j++) {
+        store.m_columns[j].resize(rows, store.m_defaults.*store.m_layout.fields[j]);
+    }
+
+    // every value goes straight to its column, as MetaDataInfo would have parsed it
+    size_t row = 0;
+    StringRef subString;
+    for(; lines.next(line); row++) {
+        StringTokenizer fields(line, ';');
+        for(int j = 0; j < columns && fields.next(subString); j++) {
+            if(subString.size > 0) {
+                double value = 0;
+                Utils::parse_double(subString.begin(), subString.end(), value);
+                store.m_columns[j][row] = value;
+            }
+        }
+    }
+    store.m_size = row;
+    store.buildIndex();
+}
+
+bool TrackStore::save(const std::string &path, uint64_t sourceStamp) const
+{
+    // written aside and renamed, a cache is either whole or missing
+    const std::string tempPath = path + ".tmp";
+    std::ofstream stream(tempPath.c_str(), std::ios::binary | std::ios::trunc);
+    if(!stream) {
+        return false;
+    }
+
+    writeValue(stream, kTrackCacheMagic);
+    writeValue(stream, kTrackCacheVersion);
+    writeValue(stream, sourceStamp);
+    writeValue(stream, (uint32_t)m_version.size());
+    stream.write(m_version.data(), m_version.size());
+    writeValue(stream, (uint64_t)m_size);
+    writeValue(stream, (uint32_t)m_columns.size());
+    for(const auto &column : m_columns) {
+        stream.write(reinterpret_cast<const char *>(column.data()), m_size * sizeof(double));
+    }
+    stream.close();
+
+    if(!stream) {
+        std::remove(tempPath.c_str());
+        return false;
+    }
+    std::remove(path.c_str());
+    return std::rename(tempPath.c_str(), path.c_str()) == 0;
+}
+
+bool TrackStore::load(const std::string &path, uint64_t sourceStamp)
+{
+    clear();
+    std::ifstream stream(path.c_str(), std::ios::binary);
+
+    uint32_t magic, formatVersion, versionLength, columns;
+    uint64_t stamp, rows;
+    if(!readValue(stream, magic) || !readValue(stream, formatVersion) || !readValue(stream, stamp) ||
+       magic != kTrackCacheMagic || formatVersion != kTrackCacheVersion || stamp != sourceStamp ||
+       !readValue(stream, versionLength) || versionLength > kMaxVersionLength) {
+        return false;
+    }
+
+    std::string version(versionLength, '\0');
+    if(!stream.read(&version[0], versionLength) || !readValue(stream, rows) || !readValue(stream, columns)) {
+        return false;
+    }
+    setVersion(version);
+
+    // the size of the file bounds the row count, a corrupt count can not make it allocate
+    const std::streamoff dataStart = stream.tellg();
+    stream.seekg(0, std::ios::end);
+    const std::streamoff dataSize = stream.tellg() - dataStart;
+    stream.seekg(dataStart);
+    if(columns != m_columns.size() || (columns && rows > (uint64_t)dataSize / sizeof(double)) ||
+       (uint64_t)dataSize != rows * columns * sizeof(double)) {
+        clear();
+        return false;
+    }
+
+    for(auto &column : m_columns) {
+        column.resize(rows);
+        if(!stream.read(reinterpret_cast<char *>(column.data()), rows * sizeof(double))) {
+            clear();
+            return false;
+        }
+    }
+    m_size = rows;
+    buildIndex();
+    return true;
+}
+
+void TrackStore::clear()
+{
+    setVersion(kVersionInvalid);
+}
+
+const std::string &TrackStore::version() const
+{
+    return m_version;
+}
+
+size_t TrackStore::size() const
+{
+    return m_size;
+}
+
+const double *TrackStore::column(MetaDataInfo::Field field) const
+{
+    for(int j = 0; j < m_layout.count; j++) {
+        if(m_layout.fields[j] == field) {
+            return m_columns[j].data();
+        }
+    }
+    return nullptr;
+}
+
+double TrackStore::value(size_t row, MetaDataInfo::Field field) const
+{
+    const double *values = column(field);
+    return values ? values[row] : m_defaults.*field;
+}
+
+MetaDataInfo TrackStore::row(size_t row) const
+{
+    MetaDataInfo info(m_defaults);
+    for(int j = 0; j < m_layout.count; j++) {
+        info.*m_layout.fields[j] = m_columns[j][row];
+    }
+    return info;
+}
+
+size_t TrackStore::lowerBound(double timestamp) const
+{
+    const double *timestamps = column(&MetaDataInfo::_timestamp);
+    if(!timestamps) {
+        return m_size;
+    }
+    return std::lower_bound(timestamps, timestamps + m_size, timestamp) - timestamps;
+}
+
+size_t TrackStore::nearestRow(double timestamp) const
+{
+    if(!m_size) {
+        return npos;
+    }
+
+    const size_t after = lowerBound(timestamp);
+    if(after == m_size) {
+        return m_size - 1;
+    }
+    if(after == 0) {
+        return 0;
+    }
+    const double *timestamps = column(&MetaDataInfo::_timestamp);
+    return timestamp - timestamps[after - 1] <= timestamps[after] - timestamp ? after - 1 : after;
+}
+
+size_t TrackStore::rowForIndex(int index) const
+{
+    const auto it = std::lower_bound(m_indexRows.begin(), m_indexRows.end(), std::make_pair(index, (uint32_t)0));
+    if(it == m_indexRows.end() || it->first != index) {
+        return npos;
+    }
+    return it->second;
+}
+
+bool TrackStore::positionForIndex(int index, double &lat, double &lng) const
+{
+    const double *latitudes = column(&MetaDataInfo::_latitude);
+    const double *longitudes = column(&MetaDataInfo::_longitude);
+    const size_t indexRow = rowForIndex(index);
+    if(!latitudes || !longitudes || indexRow == npos) {
+        return false;
+    }
+
+    // sensor lines between two GPS fixes have no coordinates, the frame is where the last fix was
+    for(size_t row = indexRow + 1; row-- > 0;) {
+        if(latitudes[row] != m_defaults._latitude && longitudes[row] != m_defaults._longitude) {
+            lat = latitudes[row];
+            lng = longitudes[row];
+            return true;
+        }
+    }
+    return false;
+}
+
+void TrackStore::setVersion(const std::string &version)
+{
+    m_version = version;
+    m_layout = MetaDataInfo::layoutForVersion(version);
+    m_defaults = MetaDataInfo(StringRef(), m_layout);
+    m_size = 0;
+    m_columns.assign(m_layout.count, std::vector<double>());
+    m_indexRows.clear();
+}
+
+void TrackStore::buildIndex()
+{
+    m_indexRows.clear();
+    const double *indexes = column(&MetaDataInfo::_index);
+    if(!indexes) {
+        return;
+    }
+
+    for(size_t row = 0; row < m_size; row++) {
+        if(indexes[row] != m_defaults._index) {
+            m_indexRows.push_back(std::make_pair((int)indexes[row], (uint32_t)row));
+        }
+    }
+    // the first row of every index is kept
+    std::stable_sort(m_indexRows.begin(), m_indexRows.end(),
+                     [](const std::pair<int, uint32_t> &a, const std::pair<int, uint32_t> &b) { return a.first < b.first; });
+    m_indexRows.erase(std::unique(m_indexRows.begin(), m_indexRows.end(),
+                                  [](const std::pair<int, uint32_t> &a, const std::pair<int, uint32_t> &b) { return a.first == b.first; }),
+                      m_indexRows.end());
+}
@@ -0,0 +1,59 @@
+#ifndef TRACKSTORE_H
+#define TRACKSTORE_H
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include "metadatainfo.h"
+
+/*
+ * Track of a sequence kept column by column, only the columns of its version are stored.
+ * Rows stay in the order of the track file, which recorders write by increasing timestamp.
+ * A missing value holds the same default as the member of a MetaDataInfo parsed from the line.
+ * The store can be saved to a binary cache so a track is parsed from text only once.
+ */
+class TrackStore
+{
+public:
+    static const size_t npos = size_t(-1);
+
+    TrackStore();
+
+    static void parseMetaData(const std::string &rawMetadata, TrackStore &store);
+
+    // 'sourceStamp' identifies the track the cache was made from, a cache of another one is not loaded
+    bool save(const std::string &path, uint64_t sourceStamp) const;
+    bool load(const std::string &path, uint64_t sourceStamp);
+
+    void clear();
+    const std::string &version() const;
+    size_t size() const;
+
+    // nullptr if the version has no such column
+    const double *column(MetaDataInfo::Field field) const;
+    double value(size_t row, MetaDataInfo::Field field) const;
+    MetaDataInfo row(size_t row) const;
+
+    // first row recorded at or after 'timestamp', size() if there is none
+    size_t lowerBound(double timestamp) const;
+    // row recorded the closest to 'timestamp', npos if the track is empty
+    size_t nearestRow(double timestamp) const;
+    // first row of a photo or video frame index, npos if the index is not in the track
+    size_t rowForIndex(int index) const;
+    // last coordinates recorded up to the row of 'index'
+    bool positionForIndex(int index, double &lat, double &lng) const;
+
+private:
+    void setVersion(const std::string &version);
+    void buildIndex();
+
+    std::string m_version;
+    MetaDataInfo::Layout m_layout;
+    MetaDataInfo m_defaults;
+    size_t m_size;
+    std::vector<std::vector<double>> m_columns;
+    std::vector<std::pair<int, uint32_t>> m_indexRows; // sorted by index, first row of each
+};
+
+#endif // TRACKSTORE_H
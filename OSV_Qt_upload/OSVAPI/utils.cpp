@@ -1,6 +1,122 @@
 #include "utils.h"
+#include <clocale>
+#include <cstdint>
+#include <cstdlib>
+
+// powers of ten exactly representable as doubles
+static const double kPowersOf10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                     1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+static const uint64_t kMaxExactMantissa = 1ULL << 53;
+static const int kMaxMantissaDigits = 19;
+static const int kMaxExponent = 100000;
+
+static bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+// Correctly rounded but slow, for the numbers the fast path can not take.
+// strtod reads the decimal point of the C locale, it is swapped in on a copy of the number.
+static double slowParseDouble(const char *first, const char *last)
+{
+    char stackBuffer[64];
+    std::string heapBuffer;
+    const size_t size = last - first;
+    char *buffer = stackBuffer;
+    if(size >= sizeof(stackBuffer)) {
+        heapBuffer.resize(size);
+        buffer = &heapBuffer[0];
+    }
+    memcpy(buffer, first, size);
+    buffer[size] = '\0';
+
+    const char decimalPoint = *localeconv()->decimal_point;
+    char *point = static_cast<char *>(memchr(buffer, '.', size));
+    if(point) {
+        *point = decimalPoint;
+    }
+    return strtod(buffer, nullptr);
+}
 
 Utils::Utils()
 {
 
 }
+
+const char *Utils::parse_double(const char *first, const char *last, double &value)
+{
+    const char *position = first;
+    while(position != last && (*position == ' ' || *position == '\t')) {
+        position++;
+    }
+    const char *numberStart = position;
+
+    bool isNegative = false;
+    if(position != last && (*position == '-' || *position == '+')) {
+        isNegative = *position == '-';
+        position++;
+    }
+
+    // up to 19 significant digits fit the mantissa, the decimal exponent is kept apart
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    bool hasDigits = false;
+    bool isTruncated = false;
+    for(; position != last && isDigit(*position); position++) {
+        hasDigits = true;
+        if(digits < kMaxMantissaDigits) {
+            mantissa = mantissa * 10 + (*position - '0');
+            digits += mantissa != 0;
+        } else {
+            isTruncated |= *position != '0';
+            exponent++;
+        }
+    }
+    if(position != last && *position == '.') {
+        for(position++; position != last && isDigit(*position); position++) {
+            hasDigits = true;
+            if(digits < kMaxMantissaDigits) {
+                mantissa = mantissa * 10 + (*position - '0');
+                digits += mantissa != 0;
+                exponent--;
+            } else {
+                isTruncated |= *position != '0';
+            }
+        }
+    }
+    if(!hasDigits) {
+        return first;
+    }
+
+    // the exponent is only taken if it has digits, "1e" is the number 1 followed by 'e'
+    if(position != last && (*position == 'e' || *position == 'E')) {
+        const char *exponentPosition = position + 1;
+        bool isNegativeExponent = false;
+        if(exponentPosition != last && (*exponentPosition == '-' || *exponentPosition == '+')) {
+            isNegativeExponent = *exponentPosition == '-';
+            exponentPosition++;
+        }
+        if(exponentPosition != last && isDigit(*exponentPosition)) {
+            int explicitExponent = 0;
+            for(; exponentPosition != last && isDigit(*exponentPosition); exponentPosition++) {
+                if(explicitExponent < kMaxExponent) {
+                    explicitExponent = explicitExponent * 10 + (*exponentPosition - '0');
+                }
+            }
+            exponent += isNegativeExponent ? -explicitExponent : explicitExponent;
+            position = exponentPosition;
+        }
+    }
+
+    // an exact mantissa times or divided by an exact power of ten is rounded once, like strtod
+    if(mantissa == 0 && !isTruncated) {
+        value = isNegative ? -0.0 : 0.0;
+    } else if(!isTruncated && mantissa <= kMaxExactMantissa && exponent >= -22 && exponent <= 22) {
+        const double result = exponent < 0 ? mantissa / kPowersOf10[-exponent] : mantissa * kPowersOf10[exponent];
+        value = isNegative ? -result : result;
+    } else {
+        value = slowParseDouble(numberStart, position);
+    }
+    return position;
+}
@@ -3,6 +3,65 @@
 
 #include <vector>
 #include <string>
+#include <cstring>
+
+/*
+ * Characters of a string that outlives the reference, nothing is copied.
+ */
+struct StringRef
+{
+    StringRef() : data(nullptr), size(0) {}
+    StringRef(const char *data, size_t size) : data(data), size(size) {}
+    StringRef(const std::string &str) : data(str.data()), size(str.size()) {}
+
+    bool empty() const { return size == 0; }
+    const char *begin() const { return data; }
+    const char *end() const { return data + size; }
+    std::string toString() const { return std::string(data, size); }
+
+    const char *data;
+    size_t size;
+};
+
+/*
+ * Walks the fields of a string the way split_string cuts it, as references into the string.
+ * n delimiters always give n + 1 fields, empty ones included.
+ */
+class StringTokenizer
+{
+public:
+    StringTokenizer(const StringRef &str, char delimiter)
+        : m_position(str.begin())
+        , m_end(str.end())
+        , m_delimiter(delimiter)
+        , m_isDone(false)
+    {
+    }
+
+    bool next(StringRef &token)
+    {
+        if(m_isDone) {
+            return false;
+        }
+        const char *found = m_position != m_end
+                ? static_cast<const char *>(memchr(m_position, m_delimiter, m_end - m_position))
+                : nullptr;
+        if(!found) {
+            // the last field, or the only one if there is no delimiter
+            found = m_end;
+            m_isDone = true;
+        }
+        token = StringRef(m_position, found - m_position);
+        m_position = found + !m_isDone;
+        return true;
+    }
+
+private:
+    const char *m_position;
+    const char *m_end;
+    char m_delimiter;
+    bool m_isDone;
+};
 
 class Utils
 {
@@ -27,6 +86,11 @@ public:
 
         return strings;
     }
+
+    // Parses the decimal number at the start of [first, last) like from_chars, whatever the locale.
+    // Leading blanks are skipped as atof does. Returns the end of the number and sets 'value', or
+    // returns 'first' and leaves 'value' as it is if there is no number.
+    static const char *parse_double(const char *first, const char *last, double &value);
 };
 
 #endif // UTILS_H
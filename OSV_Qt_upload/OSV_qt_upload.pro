@@ -9,3 +9,9 @@ SUBDIRS += \
 CONFIG += c++11
 
 UploadComponent.depends = HTTPRequest KQOAuth QTQMLUtils zlib
+
+# qmake CONFIG+=benchmarks also builds the benchmarks and the EXIF fuzz target
+benchmarks {
+    SUBDIRS += benchmarks
+    benchmarks.depends = zlib
+}
@@ -16,6 +16,7 @@
  ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
  ****************************************************************************/
 #include "GZIP.h"
+#include <QtConcurrent>
 
 //prefix zlib to avoid conflicts with qtcore
 #define Z_PREFIX
@@ -24,49 +25,36 @@
 #undef compress // conflict with GZIP::compress
 
 #define BUF_SIZE	8192
+#define CHUNK_SIZE	16384
+// 15 bits of window, +16 for a gzip header and trailer instead of the zlib ones
+#define GZIP_WINDOW_BITS	(15 + 16)
+#define PARALLEL_BLOCK_SIZE	(128 * 1024)
+#define DICTIONARY_SIZE	32768
 
-QByteArray GZIP::decompress(const QByteArray &data, int/* decSize*/)
+QByteArray GZIP::decompress(const QByteArray &data, int decSize)
 {
 	QByteArray ungzip;
+	if(decSize > 0) {
+		ungzip.reserve(decSize);
+	}
 
-	QTemporaryFile temp;
-	if(!temp.open()) {
+	GZIPInflater inflater;
+	if(!inflater.write(data.constData(), data.size(), ungzip)) {
 		return QByteArray();
 	}
-	temp.write(data);
-	temp.close();
-    gzFile file = gzopen(temp.fileName().toLatin1(), "rb");
-    if(!file) {
-        return QByteArray();
-    }
-	char buffer[10000];
-	int r;
-    while((r = gzread(file, buffer, 10000)) > 0) {
-        ungzip.append(buffer, r);
-    }
-    gzclose(file);
 
 	return ungzip;
 }
 
 QByteArray GZIP::compress(const QByteArray &ungzip)
 {
-	QString tempPath = QDir::tempPath()+"/qt_temp.gz";
+	QByteArray data;
 
-	gzFile file2 = gzopen(tempPath.toLatin1(), "wb9");
-	if(!file2) {
-		return QByteArray();
-	}
-	gzwrite(file2, ungzip.constData(), ungzip.size());
-	gzclose(file2);
-	QFile finalFile(tempPath);
-	if(!finalFile.open(QIODevice::ReadOnly)) {
+	GZIPDeflater deflater(9);
+	if(!deflater.write(ungzip.constData(), ungzip.size(), data) || !deflater.finish(data)) {
 		return QByteArray();
 	}
 
-	QByteArray data = finalFile.readAll();
-	finalFile.remove();
-
 	return data;
 }
 
@@ -92,24 +80,299 @@ bool GZIP::decompress(const QString &pathFrom, const QString &pathTo)
 	return true;
 }
 
-bool GZIP::compress(const QString &pathFrom, const QString &pathTo)
+bool GZIP::compress(const QString &pathFrom, const QString &pathTo, int level)
 {
 	QFile from(pathFrom);
 	if(!from.open(QIODevice::ReadOnly)) {
 		return false;
 	}
 
-	gzFile file = gzopen(pathTo.toLatin1(), "wb9");
+	gzFile file = gzopen(pathTo.toLatin1(), QString("wb%1").arg(qBound(1, level, 9)).toLatin1());
 	if(!file) {
 		return false;
 	}
 	char buffer[BUF_SIZE];
 	int r;
-	while((r = from.read(buffer, BUF_SIZE)) > 0) {
-		gzwrite(file, buffer, BUF_SIZE);
+	bool ok = true;
+	while(ok && (r = from.read(buffer, BUF_SIZE)) > 0) {
+		ok = gzwrite(file, buffer, r) == r;
 	}
-	gzclose(file);
+	ok = gzclose(file) == Z_OK && ok;
 	from.close();
 
+	return ok;
+}
+
+// A block of the input deflated on its own, primed with the 32 KB of input before it, like pigz
+struct DeflateBlock
+{
+	QByteArray input;
+	QByteArray dictionary;
+	bool isLast;
+	int level;
+	QByteArray output;
+	uLong crc;
+	bool ok;
+};
+
+static bool deflateChunks(z_stream &zs, int flush, QByteArray &out);
+
+static void deflateBlock(DeflateBlock &block)
+{
+	z_stream zs;
+	memset(&zs, 0, sizeof(z_stream));
+	// raw deflate, the gzip header and trailer are written once for the whole file
+	block.ok = deflateInit2(&zs, block.level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+	if(!block.ok) {
+		return;
+	}
+	if(!block.dictionary.isEmpty()) {
+		deflateSetDictionary(&zs, (const Bytef *)block.dictionary.constData(), block.dictionary.size());
+	}
+	zs.next_in = (Bytef *)block.input.constData();
+	zs.avail_in = block.input.size();
+	// a sync flush ends the block on a byte boundary without ending the deflate stream
+	block.ok = deflateChunks(zs, block.isLast ? Z_FINISH : Z_SYNC_FLUSH, block.output);
+	deflateEnd(&zs);
+
+	block.crc = crc32(crc32(0L, Z_NULL, 0), (const Bytef *)block.input.constData(), block.input.size());
+}
+
+bool GZIP::compressParallel(const QString &pathFrom, const QString &pathTo, int level)
+{
+	QFile from(pathFrom);
+	if(!from.open(QIODevice::ReadOnly)) {
+		return false;
+	}
+	QSaveFile to(pathTo);
+	if(!to.open(QIODevice::WriteOnly)) {
+		return false;
+	}
+
+	// gzip header: deflate, no name, no time, unknown OS
+	const char header[10] = {'\x1f', '\x8b', 8, 0, 0, 0, 0, 0, 0, '\xff'};
+	to.write(header, sizeof(header));
+
+	const int batchSize = qMax(1, QThread::idealThreadCount()) * 2;
+	uLong crc = crc32(0L, Z_NULL, 0);
+	quint32 totalSize = 0;
+	QByteArray dictionary;
+	bool isLast = false;
+	while(!isLast) {
+		QVector<DeflateBlock> blocks;
+		while(blocks.size() < batchSize && !isLast) {
+			DeflateBlock block;
+			block.input = from.read(PARALLEL_BLOCK_SIZE);
+			if(from.error() != QFile::NoError) {
+				to.cancelWriting();
+				return false;
+			}
+			block.dictionary = dictionary;
+			block.isLast = from.atEnd();
+			block.level = qBound(1, level, 9);
+			dictionary = block.input.right(DICTIONARY_SIZE);
+			isLast = block.isLast;
+			blocks.append(block);
+		}
+
+		QtConcurrent::blockingMap(blocks, deflateBlock);
+
+		foreach(const DeflateBlock &block, blocks) {
+			if(!block.ok || to.write(block.output) != block.output.size()) {
+				to.cancelWriting();
+				return false;
+			}
+			crc = crc32_combine(crc, block.crc, block.input.size());
+			totalSize += block.input.size();
+		}
+	}
+
+	// gzip trailer: CRC-32 and size modulo 2^32, little endian
+	char trailer[8];
+	qToLittleEndian<quint32>(crc, (uchar *)trailer);
+	qToLittleEndian<quint32>(totalSize, (uchar *)trailer + 4);
+	to.write(trailer, sizeof(trailer));
+
+	return to.commit();
+}
+
+struct GZIPInflater::Stream
+{
+	z_stream zs;
+};
+
+GZIPInflater::GZIPInflater() :
+	m_stream(new Stream), m_finished(false), m_error(false)
+{
+	memset(&m_stream->zs, 0, sizeof(z_stream));
+	m_error = inflateInit2(&m_stream->zs, GZIP_WINDOW_BITS) != Z_OK;
+}
+
+GZIPInflater::~GZIPInflater()
+{
+	inflateEnd(&m_stream->zs);
+}
+
+bool GZIPInflater::write(const char *data, int size, QByteArray &out)
+{
+	if(m_error) {
+		return false;
+	}
+
+	z_stream &zs = m_stream->zs;
+	zs.next_in = (Bytef *)data;
+	zs.avail_in = size;
+	char buffer[CHUNK_SIZE];
+	// a full output buffer may leave output pending even once all the input is consumed
+	do {
+		if(m_finished) {
+			if(!zs.avail_in) {
+				break;
+			}
+			// next gzip member
+			inflateReset(&zs);
+			m_finished = false;
+		}
+		zs.next_out = (Bytef *)buffer;
+		zs.avail_out = CHUNK_SIZE;
+		int r = inflate(&zs, Z_NO_FLUSH);
+		out.append(buffer, CHUNK_SIZE - zs.avail_out);
+		if(r == Z_STREAM_END) {
+			m_finished = true;
+		} else if(r != Z_OK && r != Z_BUF_ERROR) {
+			m_error = true;
+			return false;
+		}
+	} while(zs.avail_in > 0 || zs.avail_out == 0);
+
+	return true;
+}
+
+bool GZIPInflater::isFinished() const
+{
+	return m_finished;
+}
+
+bool GZIPInflater::hasError() const
+{
+	return m_error;
+}
+
+void GZIPInflater::reset()
+{
+	m_finished = false;
+	m_error = inflateReset(&m_stream->zs) != Z_OK;
+}
+
+struct GZIPDeflater::Stream
+{
+	z_stream zs;
+};
+
+GZIPDeflater::GZIPDeflater(int level) :
+	m_stream(new Stream), m_error(false)
+{
+	memset(&m_stream->zs, 0, sizeof(z_stream));
+	m_error = deflateInit2(&m_stream->zs, level, Z_DEFLATED, GZIP_WINDOW_BITS, 8,
+	                       Z_DEFAULT_STRATEGY) != Z_OK;
+}
+
+GZIPDeflater::~GZIPDeflater()
+{
+	deflateEnd(&m_stream->zs);
+}
+
+static bool deflateChunks(z_stream &zs, int flush, QByteArray &out)
+{
+	char buffer[CHUNK_SIZE];
+	int r;
+	do {
+		zs.next_out = (Bytef *)buffer;
+		zs.avail_out = CHUNK_SIZE;
+		r = deflate(&zs, flush);
+		if(r == Z_STREAM_ERROR) {
+			return false;
+		}
+		out.append(buffer, CHUNK_SIZE - zs.avail_out);
+	} while(zs.avail_out == 0);
+
+	return flush != Z_FINISH || r == Z_STREAM_END;
+}
+
+bool GZIPDeflater::write(const char *data, int size, QByteArray &out)
+{
+	if(m_error) {
+		return false;
+	}
+
+	m_stream->zs.next_in = (Bytef *)data;
+	m_stream->zs.avail_in = size;
+	m_error = !deflateChunks(m_stream->zs, Z_NO_FLUSH, out);
+
+	return !m_error;
+}
+
+bool GZIPDeflater::finish(QByteArray &out)
+{
+	if(m_error) {
+		return false;
+	}
+
+	m_stream->zs.next_in = Z_NULL;
+	m_stream->zs.avail_in = 0;
+	m_error = !deflateChunks(m_stream->zs, Z_FINISH, out);
+
+	return !m_error;
+}
+
+bool GZIPDeflater::hasError() const
+{
+	return m_error;
+}
+
+GZIPLineReader::GZIPLineReader(const QString &path) :
+	m_file(path), m_position(0)
+{
+}
+
+bool GZIPLineReader::open()
+{
+	return m_file.open(QIODevice::ReadOnly);
+}
+
+bool GZIPLineReader::readLine(QByteArray &line)
+{
+	int end;
+	while((end = m_buffer.indexOf('\n', m_position)) < 0) {
+		if(m_file.atEnd() || m_inflater.hasError()) {
+			// last line without a line ending
+			if(m_position >= m_buffer.size() || m_inflater.hasError()) {
+				return false;
+			}
+			end = m_buffer.size();
+			break;
+		}
+
+		m_buffer.remove(0, m_position);
+		m_position = 0;
+		char buffer[CHUNK_SIZE];
+		const qint64 r = m_file.read(buffer, CHUNK_SIZE);
+		if(r <= 0 || !m_inflater.write(buffer, r, m_buffer)) {
+			return false;
+		}
+	}
+
+	int lineEnd = end;
+	if(lineEnd > m_position && m_buffer.at(lineEnd - 1) == '\r') {
+		--lineEnd;
+	}
+	line = m_buffer.mid(m_position, lineEnd - m_position);
+	m_position = end + 1;
+
 	return true;
 }
+
+bool GZIPLineReader::hasError() const
+{
+	return m_inflater.hasError();
+}
@@ -26,7 +26,70 @@ public:
 	static QByteArray decompress(const QByteArray &data, int decSize);
 	static QByteArray compress(const QByteArray &ungzip);
 	static bool decompress(const QString &pathFrom, const QString &pathTo);
-	static bool compress(const QString &pathFrom, const QString &pathTo);
+	static bool compress(const QString &pathFrom, const QString &pathTo, int level = 6);
+	// same output format, the blocks of the file are deflated on the global thread pool
+	static bool compressParallel(const QString &pathFrom, const QString &pathTo, int level = 6);
+};
+
+// Incremental gzip decompression in memory, the input can be fed in chunks of any size.
+// Concatenated gzip members are decompressed one after the other, like gzread() does.
+class GZIPInflater
+{
+public:
+	GZIPInflater();
+	~GZIPInflater();
+
+	// appends what 'data' inflates to to 'out', false once the input is corrupt
+	bool write(const char *data, int size, QByteArray &out);
+	// true when the input fed so far ends a gzip member
+	bool isFinished() const;
+	bool hasError() const;
+	void reset();
+
+private:
+	Q_DISABLE_COPY(GZIPInflater)
+	struct Stream;
+	QScopedPointer<Stream> m_stream;
+	bool m_finished;
+	bool m_error;
+};
+
+// Incremental gzip compression in memory, finish() writes the gzip trailer.
+class GZIPDeflater
+{
+public:
+	explicit GZIPDeflater(int level = 6);
+	~GZIPDeflater();
+
+	// appends the compressed data available so far to 'out'
+	bool write(const char *data, int size, QByteArray &out);
+	bool finish(QByteArray &out);
+	bool hasError() const;
+
+private:
+	Q_DISABLE_COPY(GZIPDeflater)
+	struct Stream;
+	QScopedPointer<Stream> m_stream;
+	bool m_error;
+};
+
+// Reads the lines of a gzip file, the file is inflated only as far as the lines taken.
+class GZIPLineReader
+{
+public:
+	explicit GZIPLineReader(const QString &path);
+
+	bool open();
+	// 'line' is set without its line ending, false at the end of the data or on corrupt data
+	bool readLine(QByteArray &line);
+	bool hasError() const;
+
+private:
+	Q_DISABLE_COPY(GZIPLineReader)
+	QFile m_file;
+	GZIPInflater m_inflater;
+	QByteArray m_buffer; // inflated data, the lines before m_position were taken already
+	int m_position;
 };
 
 #endif // GZIP_H
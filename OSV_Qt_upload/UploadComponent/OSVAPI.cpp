@@ -1,6 +1,6 @@
 #include "OSVAPI.h"
 #include "metadata.h"
-#include <QCoreApplication>
+#include "uploadfiledevice.h"
 #include <QDebug>
 #include <QFileInfo>
 #include <QHttpMultiPart>
@@ -8,22 +8,16 @@
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonValue>
+#include <QMutexLocker>
 
-OSVAPI::OSVAPI(QObject* parent)
+OSVAPI::OSVAPI(QMutex* sequenceMutex, QObject* parent)
     : QObject(parent)
+    , m_transport(new UploadTransport(kUploadShards, this))
+    , m_retryScheduler(new RetryScheduler(this))
+    , m_sequenceMutex(sequenceMutex)
     , m_uploadPaused(false)
 {
     m_manager = new QNetworkAccessManager();
-
-    // connect fail signal-slots
-    connect(this, SIGNAL(NewSequenceFailed(PersistentSequence*, int)), this,
-            SLOT(onNewSequenceFailed(PersistentSequence*, int)), Qt::QueuedConnection);
-    connect(this, SIGNAL(SequenceFinishedFailed(PersistentSequence*, int)), this,
-            SLOT(onSequenceFinishedFailed(PersistentSequence*, int)), Qt::QueuedConnection);
-    connect(this, SIGNAL(NewPhotoFailed(PersistentSequence*, int, int)), this,
-            SLOT(onNewPhotoFailed(PersistentSequence*, int, int)), Qt::QueuedConnection);
-    connect(this, SIGNAL(NewVideoFailed(PersistentSequence*, int, int)), this,
-            SLOT(onNewVideoFailed(PersistentSequence*, int, int)), Qt::QueuedConnection);
 }
 
 OSVAPI::~OSVAPI()
@@ -49,11 +43,32 @@ QJsonObject OSVAPI::objectFromString(const QString& in)
     return obj;
 }
 
-void delay()
+/*
+ * Queues a failed request for another attempt.
+ * Returns false when the request was given up: the error is permanent or the retry budget of the
+ * request is spent. Giving up stops the upload with an error.
+ */
+bool OSVAPI::retryRequest(const RequestClass requestClass, const QString& key,
+                          const RequestError error, std::function<void()> retryFunc)
 {
-    const QTime dieTime(QTime::currentTime().addSecs(1));
-    while (QTime::currentTime() < dieTime)
-        QCoreApplication::processEvents(QEventLoop::AllEvents, 100);
+    if (m_uploadPaused || error == RequestError::NONE)
+    {
+        return true;
+    }
+
+    // the retry runs from a timer of the engine, outside of the calls that hold the lock
+    const auto lockedRetryFunc = [this, retryFunc]() {
+        QMutexLocker locker(m_sequenceMutex);
+        retryFunc();
+    };
+    if (m_retryScheduler->schedule(requestClass, key, error, lockedRetryFunc))
+    {
+        return true;
+    }
+
+    qDebug() << "Request " << key << " given up, error: " << (int)error;
+    emit errorFound();
+    return false;
 }
 
 void OSVAPI::requestNewSequence(PersistentSequence* sequence, const int sequenceIndex)
@@ -65,16 +80,17 @@ void OSVAPI::requestNewSequence(PersistentSequence* sequence, const int sequence
     HTTPRequest* request = new HTTPRequest(NULL, m_manager);
     connect(request, SIGNAL(newBytesDifference(qint64)), this, SIGNAL(uploadProgress(qint64)));
 
-    request->setHandlerFunc([=](QNetworkReply* reply) {
-        bool sequenceFailed = false;
-        if (reply && !m_uploadPaused)
+    request->setHandlerFunc([=](const HTTPResponse& response) {
+        QMutexLocker locker(m_sequenceMutex);
+        bool          sequenceFailed = false;
+        OSVStatusCode statusCode     = OSVStatusCode::STATUS_INCORRECT;
+        if (!m_uploadPaused)
         {
-            QByteArray  data        = reply->readAll();
+            QByteArray  data        = response.body;
             QString     string_data = QString::fromLatin1(data.data());
             QJsonObject json        = objectFromString(string_data);
             qDebug() << string_data;
-            QJsonObject   statusObj;
-            OSVStatusCode statusCode = OSVStatusCode::STATUS_INCORRECT;
+            QJsonObject statusObj;
             if (!json.isEmpty())
             {
                 statusObj  = json["status"].toObject();
@@ -90,12 +106,10 @@ void OSVAPI::requestNewSequence(PersistentSequence* sequence, const int sequence
                 sequence->setSequenceStatus(SequenceStatus::BUSY);
                 disconnect(request, SIGNAL(newBytesDifference(qint64)), this,
                            SIGNAL(uploadProgress(qint64)));
+                m_retryScheduler->succeeded(
+                    RetryScheduler::retryKey(RequestClass::SEQUENCE, sequenceIndex));
                 emit sequenceCreated(sequenceIndex);
             }
-            else if (statusCode == OSVStatusCode::BAD_LOGIN)
-            {
-                emit errorFound();
-            }
             else
             {
                 sequenceFailed = true;
@@ -108,39 +122,32 @@ void OSVAPI::requestNewSequence(PersistentSequence* sequence, const int sequence
 
         if (sequenceFailed)
         {
-            emit NewSequenceFailed(sequence, sequenceIndex);
+            onNewSequenceFailed(sequence, sequenceIndex,
+                                RetryScheduler::classifyError(response, statusCode));
         }
 
         // delete captured request
-        reply->deleteLater();
         delete request;
     });
 
-    QFile*     file(nullptr);
-    QByteArray buffer(nullptr);
-    if (!sequence->getMetadata()->getPath().isEmpty())
-    {
-        file = new QFile(sequence->getMetadata()->getPath());
-        if (!file->open(QIODevice::ReadOnly))
-        {
-            qDebug() << "Can not open!";
-        }
-        else
-        {
-            buffer = file->read(file->size());
-        }
-    }
-
     const QString token(sequence->getToken());
 
     QHttpMultiPart* map = new QHttpMultiPart(QHttpMultiPart::FormDataType);
     QHttpPart       filePart;
 
+    // metadata is streamed from disk by the multipart, which owns the device
+    UploadFileDevice* file(nullptr);
+    if (!sequence->getMetadata()->getPath().isEmpty())
+    {
+        file = new UploadFileDevice(sequence->getMetadata()->getPath(), map);
+    }
+    const bool hasMetadata = file && file->hasContent();
+
     double lat = sequence->getLat();
     double lng = sequence->getLng();
 
     bool emptyData = false;
-    if ((buffer.isEmpty() && sequence->getVideos().size()) || sequence->getToken().isEmpty() ||
+    if ((!hasMetadata && sequence->getVideos().size()) || sequence->getToken().isEmpty() ||
         !(lat && lng))
     {
         emptyData = true;
@@ -148,16 +155,14 @@ void OSVAPI::requestNewSequence(PersistentSequence* sequence, const int sequence
     else
     {
         // TO DO : select corect mime-type -> + txt
-        if (!buffer.isNull())
+        if (hasMetadata)
         {
             filePart.setHeader(QNetworkRequest::ContentTypeHeader, QVariant("application/x-gzip"));
             filePart.setHeader(
                 QNetworkRequest::ContentDispositionHeader,
                 QVariant("form-data; name=\"metaData\"; filename=\"" + file->fileName() + "\""));
-            filePart.setBody(buffer);
-            file->setParent(map);
+            filePart.setBodyDevice(file);
             map->append(filePart);
-            file->close();
         }
 
         // platform from metadata
@@ -205,16 +210,19 @@ void OSVAPI::requestNewSequence(PersistentSequence* sequence, const int sequence
     {
         // POP UP
         qDebug() << "POP UP";
+        delete map;
     }
 }
 
-void OSVAPI::onNewSequenceFailed(PersistentSequence* sequence, const int sequenceIndex)
+void OSVAPI::onNewSequenceFailed(PersistentSequence* sequence, const int sequenceIndex,
+                                 const RequestError error)
 {
     qDebug() << "New Sequence Failed!";
     sequence->setSequenceStatus(SequenceStatus::FAILED);
 
-    delay();
-    requestNewSequence(sequence, sequenceIndex);
+    retryRequest(RequestClass::SEQUENCE,
+                 RetryScheduler::retryKey(RequestClass::SEQUENCE, sequenceIndex), error,
+                 [=]() { requestNewSequence(sequence, sequenceIndex); });
 }
 
 void OSVAPI::requestSequenceFinished(
@@ -228,17 +236,18 @@ void OSVAPI::requestSequenceFinished(
     HTTPRequest* request = new HTTPRequest(NULL, m_manager);
     connect(request, SIGNAL(newBytesDifference(qint64)), this, SIGNAL(uploadProgress(qint64)));
 
-    request->setHandlerFunc([=](QNetworkReply* reply) {
-        bool sequenceFailed = false;
-        if (reply && !m_uploadPaused)
+    request->setHandlerFunc([=](const HTTPResponse& response) {
+        QMutexLocker locker(m_sequenceMutex);
+        bool          sequenceFailed = false;
+        OSVStatusCode statusCode     = OSVStatusCode::STATUS_INCORRECT;
+        if (!m_uploadPaused)
         {
-            QByteArray data        = reply->readAll();
+            QByteArray data        = response.body;
             QString    string_data = QString::fromLatin1(data.data());
             qDebug() << string_data;
             QJsonObject json = objectFromString(string_data);
 
-            QJsonObject   statusObj;
-            OSVStatusCode statusCode = OSVStatusCode::STATUS_INCORRECT;
+            QJsonObject statusObj;
             if (!json.isEmpty())
             {
                 statusObj  = json["status"].toObject();
@@ -251,6 +260,8 @@ void OSVAPI::requestSequenceFinished(
                 sequence->setSequenceStatus(SequenceStatus::SUCCESS);
                 disconnect(request, SIGNAL(newBytesDifference(qint64)), this,
                            SIGNAL(uploadProgress(qint64)));
+                m_retryScheduler->succeeded(
+                    RetryScheduler::retryKey(RequestClass::SEQUENCE_FINISHED, sequenceIndex));
                 emit SequenceFinished(sequenceIndex);
             }
             else
@@ -267,10 +278,10 @@ void OSVAPI::requestSequenceFinished(
 
         if (sequenceFailed)
         {
-            emit SequenceFinishedFailed(sequence, sequenceIndex);
+            onSequenceFinishedFailed(sequence, sequenceIndex,
+                                     RetryScheduler::classifyError(response, statusCode));
         }
 
-        reply->deleteLater();
         delete request;
     });
 
@@ -300,41 +311,54 @@ void OSVAPI::requestSequenceFinished(
     }
 }
 
-void OSVAPI::onSequenceFinishedFailed(PersistentSequence* sequence, const int sequenceIndex)
+void OSVAPI::onSequenceFinishedFailed(PersistentSequence* sequence, const int sequenceIndex,
+                                      const RequestError error)
 {
     qDebug() << "Sequence Finish Failed! Bad Reply!";
+    if (sequence->getSequenceStatus() == SequenceStatus::SUCCESS)
+    {
+        // late answer for a sequence that was already closed
+        return;
+    }
     sequence->setSequenceStatus(SequenceStatus::FAILED_FINISH);
-    delay();
-    requestSequenceFinished(sequence, sequenceIndex);
+
+    retryRequest(RequestClass::SEQUENCE_FINISHED,
+                 RetryScheduler::retryKey(RequestClass::SEQUENCE_FINISHED, sequenceIndex), error,
+                 [=]() { requestSequenceFinished(sequence, sequenceIndex); });
 }
 
-void OSVAPI::requestNewPhoto(PersistentSequence* sequence, const int sequenceIndex,
+bool OSVAPI::requestNewPhoto(PersistentSequence* sequence, const int sequenceIndex,
                              const int photoIndex)
 {
     const QList<Photo*> photoList = sequence->getPhotos();
 
-    if (m_uploadPaused || photoIndex >= photoList.count())
+    if (m_uploadPaused || photoIndex < 0 || photoIndex >= photoList.count())
     {
-        return;
+        return false;
     }
     Photo*       currentPhoto = photoList.at(photoIndex);
-    HTTPRequest* request      = new HTTPRequest(NULL, m_manager);
+    HTTPRequest* request      = new HTTPRequest(NULL, m_transport);
     connect(request, SIGNAL(newBytesDifference(qint64)), this, SIGNAL(uploadProgress(qint64)));
+    request->setTimeouts(kRequestStallTimeout, kRequestDeadline, kRequestMinimumRate);
 
-    request->setHandlerFunc([=](QNetworkReply* reply) {
+    const qint64  photoSize = currentPhoto->getSize();
+    QElapsedTimer requestTimer;
+    requestTimer.start();
+
+    request->setHandlerFunc([=](const HTTPResponse& response) {
+        QMutexLocker locker(m_sequenceMutex);
         currentPhoto->setStatus(FileStatus::BUSY);
 
-        OSVStatusCode statusCode;
+        OSVStatusCode statusCode     = OSVStatusCode::STATUS_INCORRECT;
         bool          sequenceFailed = false;
-        if (reply && !m_uploadPaused)
+        if (!m_uploadPaused)
         {
-            QByteArray data        = reply->readAll();
+            QByteArray data        = response.body;
             QString    string_data = QString::fromLatin1(data.data());
 
             QJsonObject json = objectFromString(string_data);
             qDebug() << string_data;
             QJsonObject statusObj;
-            statusCode = OSVStatusCode::STATUS_INCORRECT;
             if (!json.isEmpty())
             {
                 statusObj  = json["status"].toObject();
@@ -349,11 +373,16 @@ void OSVAPI::requestNewPhoto(PersistentSequence* sequence, const int sequenceInd
                 }
                 disconnect(request, SIGNAL(newBytesDifference(qint64)), this,
                            SIGNAL(uploadProgress(qint64)));
+                m_retryScheduler->succeeded(
+                    RetryScheduler::retryKey(RequestClass::PHOTO, sequenceIndex, photoIndex));
+                emit fileRequestFinished(requestTimer.elapsed(), photoSize);
                 emit photoUploaded(sequenceIndex, photoIndex);
             }
             else if (statusCode == OSVStatusCode::DUPLICATE)
             {
                 currentPhoto->setStatus(FileStatus::DONE);
+                m_retryScheduler->succeeded(
+                    RetryScheduler::retryKey(RequestClass::PHOTO, sequenceIndex, photoIndex));
                 emit photoUploaded(sequenceIndex, photoIndex);
             }
             else
@@ -368,24 +397,16 @@ void OSVAPI::requestNewPhoto(PersistentSequence* sequence, const int sequenceInd
         }
         if (sequenceFailed)
         {
-            emit NewPhotoFailed(sequence, sequenceIndex, photoIndex);
+            emit fileRequestFailed();
+            onNewPhotoFailed(sequence, sequenceIndex, photoIndex,
+                             RetryScheduler::classifyError(response, statusCode));
         }
 
-        reply->deleteLater();
         delete request;
     });
 
-    QFile*     imageFile(nullptr);
-    QByteArray buffer(nullptr);
-
-    imageFile = new QFile(currentPhoto->getPath());
-    if (!imageFile->open(QIODevice::ReadOnly))
-    {
-        qDebug() << "Can not open image!";
-    }
-    buffer = imageFile->read(imageFile->size());
-
-    QHttpMultiPart* map = new QHttpMultiPart(QHttpMultiPart::FormDataType);
+    QHttpMultiPart*   map       = new QHttpMultiPart(QHttpMultiPart::FormDataType);
+    UploadFileDevice* imageFile = new UploadFileDevice(currentPhoto->getPath(), map);
 
     double lat = currentPhoto->getLat();
     double lng = currentPhoto->getLng();
@@ -393,7 +414,7 @@ void OSVAPI::requestNewPhoto(PersistentSequence* sequence, const int sequenceInd
     bool isEmpty    = false;
     int  sequenceId = sequence->sequenceId();
 
-    if (buffer.isEmpty() || sequenceId < 0 || photoIndex < 0 || !(lat && lng))
+    if (!imageFile->hasContent() || sequenceId < 0 || photoIndex < 0 || !(lat && lng))
     {
         isEmpty = true;
     }
@@ -404,10 +425,8 @@ void OSVAPI::requestNewPhoto(PersistentSequence* sequence, const int sequenceInd
         imagePart.setHeader(
             QNetworkRequest::ContentDispositionHeader,
             QVariant("form-data; name=\"photo\"; filename=\"" + imageFile->fileName() + "\""));
-        imagePart.setBody(buffer);
-        imageFile->setParent(map);
+        imagePart.setBodyDevice(imageFile);
         map->append(imagePart);
-        imageFile->close();
 
         QHttpPart seqIdPart;
         seqIdPart.setHeader(QNetworkRequest::ContentDispositionHeader,
@@ -442,41 +461,58 @@ void OSVAPI::requestNewPhoto(PersistentSequence* sequence, const int sequenceInd
     {
         currentPhoto->setStatus(FileStatus::BUSY);
         request->post(url, map);
+        return true;
     }
+
+    delete map;
+    delete request;
+    return false;
 }
 
 void OSVAPI::onNewPhotoFailed(PersistentSequence* sequence, const int sequenceIndex,
-                              const int photoIndex)
+                              const int photoIndex, const RequestError error)
 {
     qDebug() << "New Photo Failed! Bad Reply! " << photoIndex;
-    delay();
-    requestNewPhoto(sequence, sequenceIndex, photoIndex);
+    const bool retried = retryRequest(
+        RequestClass::PHOTO, RetryScheduler::retryKey(RequestClass::PHOTO, sequenceIndex, photoIndex),
+        error, [=]() { requestNewPhoto(sequence, sequenceIndex, photoIndex); });
+
+    if (!retried && photoIndex < sequence->getPhotos().count())
+    {
+        // make the photo available again for a later upload
+        sequence->releaseFile(photoIndex);
+    }
 }
 
-void OSVAPI::requestNewVideo(PersistentSequence* sequence, const int sequenceIndex,
+bool OSVAPI::requestNewVideo(PersistentSequence* sequence, const int sequenceIndex,
                              const int videoIndex)
 {
     const QList<Video*> videoList = sequence->getVideos();
 
-    if (m_uploadPaused || videoIndex >= videoList.count())
+    if (m_uploadPaused || videoIndex < 0 || videoIndex >= videoList.count())
     {
-        return;
+        return false;
     }
     Video*       currentVideo = videoList.at(videoIndex);
-    HTTPRequest* request      = new HTTPRequest(NULL, m_manager);
+    HTTPRequest* request      = new HTTPRequest(NULL, m_transport);
     connect(request, SIGNAL(newBytesDifference(qint64)), this, SIGNAL(uploadProgress(qint64)));
+    request->setTimeouts(kRequestStallTimeout, kRequestDeadline, kRequestMinimumRate);
+
+    const qint64  videoSize = currentVideo->getSize();
+    QElapsedTimer requestTimer;
+    requestTimer.start();
 
-    request->setHandlerFunc([=](QNetworkReply* reply) {
+    request->setHandlerFunc([=](const HTTPResponse& response) {
+        QMutexLocker locker(m_sequenceMutex);
         currentVideo->setStatus(FileStatus::BUSY);
-        OSVStatusCode statusCode;
+        OSVStatusCode statusCode     = OSVStatusCode::STATUS_INCORRECT;
         bool          sequenceFailed = false;
-        if (reply && !m_uploadPaused)
+        if (!m_uploadPaused)
         {
-            QByteArray  data        = reply->readAll();
+            QByteArray  data        = response.body;
             QString     string_data = QString::fromLatin1(data.data());
             QJsonObject json        = objectFromString(string_data);
             QJsonObject statusObj;
-            statusCode = OSVStatusCode::STATUS_INCORRECT;
             if (!json.isEmpty())
             {
                 statusObj  = json["status"].toObject();
@@ -493,11 +529,16 @@ void OSVAPI::requestNewVideo(PersistentSequence* sequence, const int sequenceInd
                 {
                     currentVideo->setStatus(FileStatus::DONE);
                 }
+                m_retryScheduler->succeeded(
+                    RetryScheduler::retryKey(RequestClass::VIDEO, sequenceIndex, videoIndex));
+                emit fileRequestFinished(requestTimer.elapsed(), videoSize);
                 emit videoUploaded(sequenceIndex, videoIndex);
             }
             else if (statusCode == OSVStatusCode::DUPLICATE)
             {
                 currentVideo->setStatus(FileStatus::DONE);
+                m_retryScheduler->succeeded(
+                    RetryScheduler::retryKey(RequestClass::VIDEO, sequenceIndex, videoIndex));
                 emit videoUploaded(sequenceIndex, videoIndex);
             }
             else
@@ -512,33 +553,21 @@ void OSVAPI::requestNewVideo(PersistentSequence* sequence, const int sequenceInd
 
         if (sequenceFailed)
         {
-            reply->deleteLater();
-            emit NewVideoFailed(sequence, sequenceIndex, videoIndex);
+            emit fileRequestFailed();
+            onNewVideoFailed(sequence, sequenceIndex, videoIndex,
+                             RetryScheduler::classifyError(response, statusCode));
         }
 
-        reply->deleteLater();
         delete request;
     });
 
-    QFile*     videoFile(nullptr);
-    QByteArray buffer(nullptr);
-
-    videoFile = new QFile(currentVideo->getPath());
-    if (!videoFile->open(QIODevice::ReadOnly))
-    {
-        qDebug() << "Can not open image!";
-    }
-    else
-    {
-        buffer = videoFile->read(videoFile->size());
-    }
-
-    QHttpMultiPart* map = new QHttpMultiPart(QHttpMultiPart::FormDataType);
+    QHttpMultiPart*   map       = new QHttpMultiPart(QHttpMultiPart::FormDataType);
+    UploadFileDevice* videoFile = new UploadFileDevice(currentVideo->getPath(), map);
 
     bool isEmpty    = false;
     int  sequenceId = sequence->sequenceId();
 
-    if (buffer.isEmpty() || sequenceId < 0 || videoIndex < 0)
+    if (!videoFile->hasContent() || sequenceId < 0 || videoIndex < 0)
     {
         isEmpty = true;
     }
@@ -549,10 +578,8 @@ void OSVAPI::requestNewVideo(PersistentSequence* sequence, const int sequenceInd
         videoPart.setHeader(
             QNetworkRequest::ContentDispositionHeader,
             QVariant("form-data; name=\"video\"; filename=\"" + videoFile->fileName() + "\""));
-        videoPart.setBody(buffer);
-        videoFile->setParent(map);
+        videoPart.setBodyDevice(videoFile);
         map->append(videoPart);
-        videoFile->close();
 
         QHttpPart seqIdPart;
         seqIdPart.setHeader(QNetworkRequest::ContentDispositionHeader,
@@ -580,22 +607,33 @@ void OSVAPI::requestNewVideo(PersistentSequence* sequence, const int sequenceInd
     {
         currentVideo->setStatus(FileStatus::BUSY);
         request->post(url, map);
+        return true;
     }
 
-    delete videoFile;
+    delete map;
+    delete request;
+    return false;
 }
 
 void OSVAPI::onNewVideoFailed(PersistentSequence* sequence, const int sequenceIndex,
-                              const int videoIndex)
+                              const int videoIndex, const RequestError error)
 {
     qDebug() << "New video Failed! Bad Reply! " << videoIndex;
-    delay();
-    requestNewVideo(sequence, sequenceIndex, videoIndex);
+    const bool retried = retryRequest(
+        RequestClass::VIDEO, RetryScheduler::retryKey(RequestClass::VIDEO, sequenceIndex, videoIndex),
+        error, [=]() { requestNewVideo(sequence, sequenceIndex, videoIndex); });
+
+    if (!retried && videoIndex < sequence->getVideos().count())
+    {
+        // make the video available again for a later upload
+        sequence->releaseFile(videoIndex);
+    }
 }
 
 void OSVAPI::pauseUpload()
 {
     m_uploadPaused = true;
+    m_retryScheduler->cancelAll();
 }
 
 void OSVAPI::resumeUpload()
@@ -3,24 +3,29 @@
 
 #include "httprequest.h"
 #include "persistentsequence.h"
+#include "retryscheduler.h"
+#include "uploadtransport.h"
 #include "uploadcomponentconstants.h"
+#include <QElapsedTimer>
 #include <QEventLoop>
 #include <QFile>
+#include <QMutex>
 #include <QObject>
 
 class OSVAPI : public QObject
 {
    Q_OBJECT
 public:
-   explicit OSVAPI(QObject* parent = 0);
+   // 'sequenceMutex' guards the sequences, it is held while a reply or a retry changes them
+   explicit OSVAPI(QMutex* sequenceMutex, QObject* parent = 0);
    ~OSVAPI();
 
    static QJsonObject objectFromString(const QString& in);
 
    void requestNewSequence(PersistentSequence* sequence, const int sequenceIndex);
    void requestSequenceFinished(PersistentSequence* sequence, const int sequenceIndex);
-   void requestNewPhoto(PersistentSequence* sequence, const int sequenceIndex, const int photoIndex);
-   void requestNewVideo(PersistentSequence* sequence, const int sequenceIndex, const int videoIndex);
+   bool requestNewPhoto(PersistentSequence* sequence, const int sequenceIndex, const int photoIndex);
+   bool requestNewVideo(PersistentSequence* sequence, const int sequenceIndex, const int videoIndex);
 
    void pauseUpload();
    void resumeUpload();
@@ -33,19 +38,27 @@ signals:
    void sequenceCreated(int sequenceIndex);
    void errorFound();
 
-   void NewSequenceFailed(PersistentSequence* sequence, const int sequenceIndex);
-   void SequenceFinishedFailed(PersistentSequence* sequence, const int sequenceIndex);
-   void NewPhotoFailed(PersistentSequence* sequence, const int sequenceIndex, const int photoIndex);
-   void NewVideoFailed(PersistentSequence* sequence, const int sequenceIndex, const int videoIndex);
+   // per file request statistics, latency in ms
+   void fileRequestFinished(qint64 latency, qint64 bytes);
+   void fileRequestFailed();
 
-public slots:
-   void onNewSequenceFailed(PersistentSequence* sequence, const int sequenceIndex);
-   void onSequenceFinishedFailed(PersistentSequence* sequence, const int sequenceIndex);
-   void onNewPhotoFailed(PersistentSequence* sequence, const int sequenceIndex, const int photoIndex);
-   void onNewVideoFailed(PersistentSequence* sequence, const int sequenceIndex, const int videoIndex);
+private:
+   void onNewSequenceFailed(PersistentSequence* sequence, const int sequenceIndex,
+                            const RequestError error);
+   void onSequenceFinishedFailed(PersistentSequence* sequence, const int sequenceIndex,
+                                 const RequestError error);
+   void onNewPhotoFailed(PersistentSequence* sequence, const int sequenceIndex,
+                         const int photoIndex, const RequestError error);
+   void onNewVideoFailed(PersistentSequence* sequence, const int sequenceIndex,
+                         const int videoIndex, const RequestError error);
+   bool retryRequest(const RequestClass requestClass, const QString& key, const RequestError error,
+                     std::function<void()> retryFunc);
 
 private:
    QNetworkAccessManager* m_manager;
+   UploadTransport*       m_transport;
+   RetryScheduler*        m_retryScheduler;
+   QMutex*                m_sequenceMutex;
    bool                   m_uploadPaused;
 };
 
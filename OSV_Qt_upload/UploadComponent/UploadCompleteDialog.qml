@@ -33,7 +33,7 @@ Dialog {
                 Layout.alignment: Qt.AlignCenter
             }
             Text {
-                text: uploadSpeed.text
+                text: qsTr("Average upload speed: ") + UtilFunctions.editFolderSize(uploadController.averageUploadSpeed) + "/s"
                 Layout.alignment: Qt.AlignCenter
             }
 
@@ -16,8 +16,16 @@ SOURCES += main.cpp \
     video.cpp \
     metadata.cpp \
     uploadcontroller.cpp \
+    uploadengine.cpp \
+    rateestimator.cpp \
     elapsedtimecounter.cpp \
-    OSVAPI.cpp
+    OSVAPI.cpp \
+    uploadfiledevice.cpp \
+    retryscheduler.cpp \
+    concurrencycontroller.cpp \
+    directoryscanner.cpp \
+    scancache.cpp \
+    exifbatch.cpp
 
 RESOURCES += qml.qrc
 
@@ -39,8 +47,16 @@ HEADERS += \
     video.h \
     metadata.h \
     uploadcontroller.h \
+    uploadengine.h \
+    rateestimator.h \
     elapsedtimecounter.h \
-    OSVAPI.h
+    OSVAPI.h \
+    uploadfiledevice.h \
+    retryscheduler.h \
+    concurrencycontroller.h \
+    directoryscanner.h \
+    scancache.h \
+    exifbatch.h
 
 #http libs
 win32:CONFIG(release, debug|release): LIBS += -L$$OUT_PWD/../HTTPRequest/release/ -lHTTPRequest
@@ -42,14 +42,15 @@ Window {
                         id: dropAreaText
                         width : parent.width
                         height : parent.height
-                        visible: persistentController.sequences.count == 0 || dropArea.containsDrag
+                        visible: persistentController.sequences.count == 0 || dropArea.containsDrag || persistentController.isScanning
                         color : "lightsteelblue"
 
                         Text {
                             anchors.fill: parent
                             verticalAlignment: Text.AlignVCenter
                             horizontalAlignment: Text.AlignHCenter
-                            text : qsTr("Drop files here")
+                            text : persistentController.isScanning ? qsTr("Scanning files: ") + persistentController.scannedFiles + " / " + persistentController.filesToScan
+                                                                   : qsTr("Drop files here")
                         }
                     }
 
@@ -57,6 +58,7 @@ Window {
                     DropArea {
                         id : dropArea
                         anchors.fill: parent
+                        enabled: !uploadController.isUploadStarted
                         onEntered: {
                             for (var i = 0; i < drag.urls.length; i++)
                             {
@@ -88,7 +90,7 @@ Window {
                     // view of the list of folders
                     TableView {
                         id: addedFolders
-                        visible: persistentController.sequences.count > 0 && !dropArea.containsDrag
+                        visible: persistentController.sequences.count > 0 && !dropArea.containsDrag && !persistentController.isScanning
                         anchors.fill: parent
                         model : persistentController.sequences
                         selectionMode: SelectionMode.MultiSelection
@@ -195,11 +197,19 @@ Window {
                             }
                         }
 
+                        // button used for stopping the scan of the added folders
+                        CustomButton {
+                            id : cancelScanButton
+                            text : qsTr("Cancel scan")
+                            visible: persistentController.isScanning
+                            onClicked: persistentController.cancelScan();
+                        }
+
                         // button user for removing selected folder from the list
                         CustomButton {
                             id : removeFolderButton
                             text : qsTr("Remove folder")
-                            enabled: persistentController.sequences.count > 0 && addedFolders.selection.count
+                            enabled: persistentController.sequences.count > 0 && addedFolders.selection.count && !uploadController.isUploadStarted
                             onClicked: {
                                 var indexes = [];
                                 addedFolders.selection.forEach(function (rowIndex) {
@@ -215,7 +225,7 @@ Window {
                         {
                             id: uploadButton
                             text: qsTr("Start")
-                            enabled: loginController.isLoggedIn && persistentController.sequences.count > 0 && !uploadController.isUploadStarted
+                            enabled: loginController.isLoggedIn && persistentController.sequences.count > 0 && !uploadController.isUploadStarted && !persistentController.isScanning
                             visible: !uploadController.isUploadStarted
                             onClicked: uploadController.startUpload();
                         }
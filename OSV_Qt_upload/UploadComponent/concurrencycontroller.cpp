@@ -0,0 +1,158 @@
+#include "concurrencycontroller.h"
+#include "uploadcomponentconstants.h"
+#include <QDebug>
+
+ConcurrencyController::ConcurrencyController(QObject* parent)
+    : QObject(parent)
+    , m_minConcurrency(kMinConcurrency)
+    , m_maxConcurrency(kMaxConcurrency)
+    , m_currentConcurrency(kCountThreads)
+{
+    connect(&m_sampleTimer, &QTimer::timeout, this, &ConcurrencyController::evaluate);
+    reset();
+}
+
+void ConcurrencyController::start()
+{
+    resetSample();
+    m_sampleClock.start();
+    m_sampleTimer.start(kConcurrencySampleInterval);
+}
+
+void ConcurrencyController::stop()
+{
+    m_sampleTimer.stop();
+}
+
+void ConcurrencyController::reset()
+{
+    stop();
+    resetSample();
+    m_baseLatency         = 0;
+    m_lastGoodput         = 0;
+    m_lastStepWasIncrease = false;
+    setCurrentConcurrency(kCountThreads);
+}
+
+void ConcurrencyController::resetSample()
+{
+    m_sampleBytes      = 0;
+    m_sampleRequests   = 0;
+    m_sampleFailures   = 0;
+    m_sampleLatencySum = 0;
+}
+
+void ConcurrencyController::onBytesSent(qint64 bytes)
+{
+    m_sampleBytes += bytes;
+}
+
+void ConcurrencyController::onRequestFinished(qint64 latency, qint64 bytes)
+{
+    if (bytes <= 0)
+    {
+        return;
+    }
+    // latency is normalized by size, photos and videos of any length are comparable this way
+    m_sampleLatencySum += (double)latency * 1024 / bytes;
+    ++m_sampleRequests;
+}
+
+void ConcurrencyController::onRequestFailed()
+{
+    ++m_sampleFailures;
+}
+
+void ConcurrencyController::evaluate()
+{
+    const qint64 elapsed = m_sampleClock.restart();
+    if (elapsed <= 0 || (!m_sampleBytes && !m_sampleRequests && !m_sampleFailures))
+    {
+        // nothing was in flight, there is nothing to learn from this interval
+        resetSample();
+        return;
+    }
+
+    const double goodput = (double)m_sampleBytes * 1000 / elapsed;
+    const double latency = m_sampleRequests ? m_sampleLatencySum / m_sampleRequests : 0;
+    if (latency > 0 && (m_baseLatency <= 0 || latency < m_baseLatency))
+    {
+        m_baseLatency = latency;
+    }
+
+    const bool queueing = latency > 0 && latency > kConcurrencyLatencyInflation * m_baseLatency;
+    const bool improved = goodput > m_lastGoodput * (1 + kConcurrencyGoodputGain);
+    const bool degraded = goodput < m_lastGoodput * (1 - kConcurrencyGoodputGain);
+
+    int next = m_currentConcurrency;
+    if (m_sampleFailures || (queueing && !improved))
+    {
+        // multiplicative decrease
+        next                  = (int)(m_currentConcurrency * kConcurrencyDecreaseFactor);
+        m_lastStepWasIncrease = false;
+    }
+    else if (m_lastStepWasIncrease && degraded)
+    {
+        // the last probe did not pay off, step back
+        next                  = m_currentConcurrency - 1;
+        m_lastStepWasIncrease = false;
+    }
+    else
+    {
+        // additive increase
+        next                  = m_currentConcurrency + 1;
+        m_lastStepWasIncrease = true;
+    }
+
+    qDebug() << "Concurrency sample: goodput " << (qint64)goodput << " B/s, latency " << latency
+             << " ms/KB, failures " << m_sampleFailures << " -> " << next;
+
+    m_lastGoodput = goodput;
+    resetSample();
+    setCurrentConcurrency(next);
+}
+
+// Getters
+int ConcurrencyController::minConcurrency() const
+{
+    return m_minConcurrency;
+}
+
+int ConcurrencyController::maxConcurrency() const
+{
+    return m_maxConcurrency;
+}
+
+int ConcurrencyController::currentConcurrency() const
+{
+    return m_currentConcurrency;
+}
+
+// Setters
+void ConcurrencyController::setMinConcurrency(const int minConcurrency)
+{
+    m_minConcurrency = qBound(1, minConcurrency, kMaxConcurrency);
+    if (m_maxConcurrency < m_minConcurrency)
+    {
+        setMaxConcurrency(m_minConcurrency);
+    }
+    emit minConcurrencyChanged();
+    setCurrentConcurrency(m_currentConcurrency);
+}
+
+void ConcurrencyController::setMaxConcurrency(const int maxConcurrency)
+{
+    m_maxConcurrency = qBound(m_minConcurrency, maxConcurrency, kMaxConcurrency);
+    emit maxConcurrencyChanged();
+    setCurrentConcurrency(m_currentConcurrency);
+}
+
+void ConcurrencyController::setCurrentConcurrency(const int currentConcurrency)
+{
+    const int bounded = qBound(m_minConcurrency, currentConcurrency, m_maxConcurrency);
+    if (bounded != m_currentConcurrency)
+    {
+        m_currentConcurrency = bounded;
+        emit currentConcurrencyChanged();
+    }
+}
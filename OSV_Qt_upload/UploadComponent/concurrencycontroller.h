@@ -0,0 +1,66 @@
+#ifndef CONCURRENCYCONTROLLER_H
+#define CONCURRENCYCONTROLLER_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QTimer>
+
+/*
+ * Decides how many files are uploaded in parallel.
+ * Works in AIMD fashion on fixed sampling intervals: while the goodput keeps up and the per-byte
+ * latency of the requests does not inflate the window grows by one, failures or a growing latency
+ * without a goodput gain shrink it multiplicatively.
+ */
+class ConcurrencyController : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ConcurrencyController(QObject* parent = 0);
+
+    void start();
+    void stop();
+    void reset();
+
+    // Getters
+    int minConcurrency() const;
+    int maxConcurrency() const;
+    int currentConcurrency() const;
+
+    // Setters
+    void setMinConcurrency(const int minConcurrency);
+    void setMaxConcurrency(const int maxConcurrency);
+
+signals:
+    void minConcurrencyChanged();
+    void maxConcurrencyChanged();
+    void currentConcurrencyChanged();
+
+public slots:
+    void onBytesSent(qint64 bytes);
+    void onRequestFinished(qint64 latency, qint64 bytes);
+    void onRequestFailed();
+
+private slots:
+    void evaluate();
+
+private:
+    void setCurrentConcurrency(const int currentConcurrency);
+    void resetSample();
+
+    int m_minConcurrency;
+    int m_maxConcurrency;
+    int m_currentConcurrency;
+
+    QTimer        m_sampleTimer;
+    QElapsedTimer m_sampleClock;
+    qint64        m_sampleBytes;
+    int           m_sampleRequests;
+    int           m_sampleFailures;
+    double        m_sampleLatencySum;  // ms per KB, summed over the finished requests
+
+    double m_baseLatency;  // lowest ms per KB seen during the upload
+    double m_lastGoodput;  // B/s of the previous sample
+    bool   m_lastStepWasIncrease;
+};
+
+#endif  // CONCURRENCYCONTROLLER_H
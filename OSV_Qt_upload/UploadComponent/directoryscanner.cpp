@@ -0,0 +1,169 @@
+#include "directoryscanner.h"
+#include "uploadcomponentconstants.h"
+#include <QDebug>
+#include <QDirIterator>
+#include <QtConcurrent>
+
+DirectoryScanner::DirectoryScanner(QObject* parent)
+    : QObject(parent)
+{
+    connect(&m_watcher, SIGNAL(finished()), this, SLOT(onScanFinished()));
+    connect(&m_progressTimer, SIGNAL(timeout()), this, SLOT(onProgressTimeout()));
+}
+
+DirectoryScanner::~DirectoryScanner()
+{
+    cancel();
+    m_watcher.waitForFinished();
+}
+
+void DirectoryScanner::start(const QStringList& paths, const QSet<QString>& knownPaths,
+                             const bool recursive, const QSharedPointer<ScanCache>& cache)
+{
+    if (isRunning())
+    {
+        return;
+    }
+
+    QSharedPointer<ScanProgress> progress(new ScanProgress());
+    m_progress = progress;
+    // the job holds its own references, the scanner may go away before it ends
+    m_watcher.setFuture(QtConcurrent::run(
+        [=]() { return scan(paths, knownPaths, recursive, progress.data(), cache.data()); }));
+    m_progressTimer.start(kScanProgressInterval);
+    emit progressChanged(0, 0);
+}
+
+void DirectoryScanner::cancel()
+{
+    if (m_progress)
+    {
+        m_progress->isCancelled.store(1);
+    }
+}
+
+bool DirectoryScanner::isRunning() const
+{
+    return m_watcher.isRunning();
+}
+
+QList<ScannedDirectory> DirectoryScanner::scan(const QStringList& paths,
+                                               const QSet<QString>& knownPaths,
+                                               const bool recursive, ScanProgress* progress,
+                                               ScanCache* cache)
+{
+    QList<ScannedDirectory> directories;
+    QStringList             queue(paths);
+    while (!queue.isEmpty() && !progress->isCancelled.load())
+    {
+        const QString front = queue.takeFirst();
+
+        const ScannedDirectory directory = scanDirectory(front, progress, cache);
+        if (directory.photos.validCount() || directory.videoPaths.size())
+        {
+            directories.append(directory);
+        }
+
+        QDirIterator itDir(front, QDir::Dirs | QDir::NoDotAndDotDot);
+        while (recursive && itDir.hasNext())  // search for sub directories
+        {
+            itDir.next();
+            if (!knownPaths.contains(itDir.filePath()))
+            {
+                queue.push_back(itDir.filePath());
+            }
+        }
+    }
+    return directories;
+}
+
+ScannedDirectory DirectoryScanner::scanDirectory(const QString& path, ScanProgress* progress,
+                                                 ScanCache* cache)
+{
+    ScannedDirectory directory;
+    directory.path     = path;
+    directory.hasTrack = false;
+
+    QString      trackPath;
+    QDirIterator itMetaData(path, QStringList() << "track.txt.gz"
+                                                << "track.txt",
+                            QDir::Files);
+    while (itMetaData.hasNext())
+    {
+        itMetaData.next();
+        if (itMetaData.fileInfo().size() < kGigaByte && itMetaData.fileInfo().suffix() == "gz")
+        {
+            directory.metadataPath = itMetaData.filePath();
+            break;
+        }
+        else if (itMetaData.fileInfo().size() < kGigaByte)
+        {
+            trackPath = itMetaData.filePath();
+        }
+    }
+
+    // a plain track is compressed by the upload engine before its sequence is created, scanning
+    // never writes to the folders
+    if (directory.metadataPath.isEmpty() && !trackPath.isEmpty() &&
+        !QDir(path).entryList(QStringList() << "*.mp4", QDir::Files).isEmpty())
+    {
+        directory.metadataPath = trackPath;
+    }
+
+    if (!directory.metadataPath.isEmpty())
+    {
+        const QFileInfo trackFileInfo(directory.metadataPath);
+        directory.hasTrack = cache && cache->findTrack(trackFileInfo, directory.track);
+        if (!directory.hasTrack)
+        {
+            directory.hasTrack = Metadata::readTrackInfo(directory.metadataPath, directory.track);
+            if (directory.hasTrack && cache)
+            {
+                cache->insertTrack(trackFileInfo, directory.track);
+            }
+        }
+
+        QDirIterator itVideoFile(path, QStringList() << "*.mp4", QDir::Files);
+        while (itVideoFile.hasNext())
+        {
+            itVideoFile.next();
+            const qint64 videoSize = itVideoFile.fileInfo().size();
+            if (videoSize > 0 && videoSize < kGigaByte)
+            {
+                directory.videoPaths.append(itVideoFile.filePath());
+            }
+        }
+        return directory;
+    }
+
+    QStringList  photoPaths;
+    QDirIterator itPhotoFile(path, QStringList() << "*.jpg"
+                                                 << "*.jpeg",
+                             QDir::Files);
+    while (itPhotoFile.hasNext())
+    {
+        photoPaths.append(itPhotoFile.next());
+    }
+    progress->filesToScan.fetchAndAddRelaxed(photoPaths.size());
+
+    directory.photos = ExifBatch::extract(photoPaths, cache, progress);
+    return directory;
+}
+
+void DirectoryScanner::onProgressTimeout()
+{
+    if (m_progress)
+    {
+        emit progressChanged(m_progress->scannedFiles.load(), m_progress->filesToScan.load());
+    }
+}
+
+void DirectoryScanner::onScanFinished()
+{
+    m_progressTimer.stop();
+    onProgressTimeout();
+
+    const bool isCancelled = m_progress && m_progress->isCancelled.load();
+    qDebug() << "Scan finished, cancelled: " << isCancelled;
+    emit finished(m_watcher.result(), isCancelled);
+}
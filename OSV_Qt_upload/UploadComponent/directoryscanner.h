@@ -0,0 +1,79 @@
+#ifndef DIRECTORYSCANNER_H
+#define DIRECTORYSCANNER_H
+
+#include "exifbatch.h"
+#include "metadata.h"
+#include "scancache.h"
+#include <QAtomicInt>
+#include <QFutureWatcher>
+#include <QObject>
+#include <QSet>
+#include <QSharedPointer>
+#include <QStringList>
+#include <QTimer>
+
+/*
+ * Content of a directory that can become a sequence.
+ * Directories with a track file are video sequences, the others photo sequences.
+ */
+struct ScannedDirectory
+{
+    QString          path;
+    QString          metadataPath;
+    TrackInfo        track;
+    bool             hasTrack;
+    ExifBatchResult  photos;
+    QStringList      videoPaths;
+};
+
+/*
+ * Counters shared between the scan workers and the GUI thread.
+ */
+struct ScanProgress
+{
+    QAtomicInt filesToScan;
+    QAtomicInt scannedFiles;
+    QAtomicInt isCancelled;
+};
+
+/*
+ * Scans dropped folders off the GUI thread.
+ * A walker job goes through the directories breadth first and the photos of every directory are
+ * EXIF parsed in one batch on the global thread pool. The results are handed back on the thread
+ * of the scanner once the whole scan is done.
+ */
+class DirectoryScanner : public QObject
+{
+    Q_OBJECT
+public:
+    explicit DirectoryScanner(QObject* parent = 0);
+    ~DirectoryScanner();
+
+    void start(const QStringList& paths, const QSet<QString>& knownPaths, const bool recursive,
+               const QSharedPointer<ScanCache>& cache);
+    void cancel();
+    bool isRunning() const;
+
+    // runs on the calling thread, only the EXIF parsing is spread on the thread pool
+    static QList<ScannedDirectory> scan(const QStringList& paths, const QSet<QString>& knownPaths,
+                                        const bool recursive, ScanProgress* progress,
+                                        ScanCache* cache);
+
+signals:
+    void progressChanged(int scannedFiles, int filesToScan);
+    void finished(const QList<ScannedDirectory>& directories, bool isCancelled);
+
+private slots:
+    void onScanFinished();
+    void onProgressTimeout();
+
+private:
+    static ScannedDirectory scanDirectory(const QString& path, ScanProgress* progress,
+                                          ScanCache* cache);
+
+    QFutureWatcher<QList<ScannedDirectory>> m_watcher;
+    QSharedPointer<ScanProgress>            m_progress;
+    QTimer                                  m_progressTimer;
+};
+
+#endif  // DIRECTORYSCANNER_H
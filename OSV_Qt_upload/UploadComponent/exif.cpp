@@ -257,7 +257,7 @@ bool extract_values(C &container, const unsigned char *buf, const unsigned base,
   uint32_t reversed_data;
   // if data fits into 4 bytes, they are stored directly in
   // the data field in IFEntry
-  if (sizeof(T) * entry.length() <= 4) {
+  if (entry.length() <= 4 / sizeof(T)) {
     if (alignIntel) {
       reversed_data = entry.data();
     } else {
@@ -274,10 +274,12 @@ bool extract_values(C &container, const unsigned char *buf, const unsigned base,
     }
     data = reinterpret_cast<const unsigned char *>(&(reversed_data));
   } else {
-    data = buf + base + entry.data();
-    if (data + sizeof(T) * entry.length() > buf + len) {
+    // compared as offsets, pointers past the buffer are undefined
+    const size_t offset = static_cast<size_t>(base) + entry.data();
+    if (offset > len || entry.length() > (len - offset) / sizeof(T)) {
       return false;
     }
+    data = buf + offset;
   }
   container.resize(entry.length());
   for (size_t i = 0; i < entry.length(); ++i) {
@@ -322,7 +324,7 @@ IFEntry parseIFEntry_temp(const unsigned char *buf, const unsigned offs,
   IFEntry result;
 
   // check if there even is enough data for IFEntry in the buffer
-  if (buf + offs + 12 > buf + len) {
+  if (offs > len || len - offs < 12) {
     result.tag(0xFF);
     return result;
   }
@@ -347,7 +349,8 @@ IFEntry parseIFEntry_temp(const unsigned char *buf, const unsigned offs,
       }
       // and cut zero byte at the end, since we don't want that in the
       // std::string
-      if (result.val_string()[result.val_string().length() - 1] == '\0') {
+      if (!result.val_string().empty() &&
+          result.val_string()[result.val_string().length() - 1] == '\0') {
         result.val_string().resize(result.val_string().length() - 1);
       }
       break;
@@ -376,6 +379,8 @@ IFEntry parseIFEntry_temp(const unsigned char *buf, const unsigned offs,
     default:
       result.tag(0xFF);
   }
+  // the values are read with front() by the callers, an empty entry is unusable
+  if (result.length() == 0) result.tag(0xFF);
   return result;
 }
 
@@ -408,6 +413,111 @@ IFEntry parseIFEntry(const unsigned char *buf, const unsigned offs,
     return std::move(parseIFEntry_temp<false>(buf, offs, base, len));
   }
 }
+
+// Resolves an IFD pointer, which is relative to the TIFF header, to an offset
+// into the segment. 'len' is returned if the IFD entry count is not inside the
+// segment. The operands are compared before they are added, the sum of a
+// hostile pointer wraps around.
+unsigned resolveIFDOffset(unsigned tiff_header_start, unsigned value,
+                          unsigned len) {
+  if (tiff_header_start > len || value > len - tiff_header_start) return len;
+  const unsigned offs = tiff_header_start + value;
+  if (offs >= len || len - offs < 4) return len;
+  return offs;
+}
+
+// Number of entries of the IFD at 'offs', -1 if the entry count, the 12 byte
+// entries and the 4 byte offset to the next IFD do not fit in the segment.
+int parseIFDEntryCount(const unsigned char *buf, unsigned len, bool alignIntel,
+                       unsigned offs) {
+  if (offs >= len || len - offs < 6) return -1;
+  const unsigned num_entries = parse_value<uint16_t>(buf + offs, alignIntel);
+  if (num_entries > (len - offs - 6) / 12) return -1;
+  return num_entries;
+}
+}
+
+namespace {
+
+// EXIFStream over a buffer already in memory
+class BufferStream : public easyexif::EXIFStream {
+ public:
+  BufferStream(const unsigned char *buf, unsigned len)
+      : buf_(buf), len_(len), offs_(0) {}
+  unsigned read(unsigned char *buf, unsigned len) {
+    const unsigned count = std::min(len, len_ - offs_);
+    std::copy(buf_ + offs_, buf_ + offs_ + count, buf);
+    offs_ += count;
+    return count;
+  }
+  bool skip(unsigned len) {
+    if (len > len_ - offs_) return false;
+    offs_ += len;
+    return true;
+  }
+
+ private:
+  const unsigned char *buf_;
+  unsigned len_;
+  unsigned offs_;
+};
+}
+
+//
+// Walks the JPEG markers up to the EXIF segment.
+//
+// Every marker is 0xFF followed by a code, optionally preceded by 0xFF fill
+// bytes. Markers without payload (TEM, RSTn) are skipped, the others carry a
+// 2 byte length in Motorola byte order that includes the length field itself.
+// The EXIF APP1 segment has to contain at least the TIFF header, otherwise the
+// EXIF data is corrupt. So the minimum length specified here has to be:
+//   2 bytes: section size
+//   6 bytes: "Exif\0\0" string
+//   2 bytes: TIFF header (either "II" or "MM" string)
+//   2 bytes: TIFF magic (short 0x2a00 in Motorola byte order)
+//   4 bytes: Offset to first IFD
+// =========
+//  16 bytes
+//
+int easyexif::EXIFInfo::readEXIFSegment(EXIFStream &stream,
+                                        std::vector<unsigned char> &segment) {
+  unsigned char header[4];
+  if (stream.read(header, 2) != 2 || header[0] != 0xFF || header[1] != 0xD8)
+    return PARSE_EXIF_ERROR_NO_JPEG;
+
+  for (;;) {
+    if (stream.read(header, 2) != 2 || header[0] != 0xFF)
+      return PARSE_EXIF_ERROR_CORRUPT;
+    while (header[1] == 0xFF) {
+      if (stream.read(header + 1, 1) != 1) return PARSE_EXIF_ERROR_CORRUPT;
+    }
+
+    const unsigned char marker = header[1];
+    if (marker == 0xDA || marker == 0xD9) {
+      // start of the image data (or its end), there is no EXIF before it
+      return PARSE_EXIF_ERROR_NO_EXIF;
+    }
+    if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7)) continue;
+
+    if (stream.read(header + 2, 2) != 2) return PARSE_EXIF_ERROR_CORRUPT;
+    const unsigned section_length = parse_value<uint16_t>(header + 2, false);
+    if (section_length < 2) return PARSE_EXIF_ERROR_CORRUPT;
+
+    if (marker == 0xE1) {
+      segment.resize(section_length - 2);
+      if (stream.read(segment.data(), section_length - 2) != section_length - 2)
+        return PARSE_EXIF_ERROR_CORRUPT;
+      if (segment.size() >= 6 &&
+          std::equal(segment.begin(), segment.begin() + 6, "Exif\0\0")) {
+        if (section_length < 16) return PARSE_EXIF_ERROR_CORRUPT;
+        return PARSE_EXIF_SUCCESS;
+      }
+      // another APP1 payload (XMP), the EXIF one may still follow
+      continue;
+    }
+
+    if (!stream.skip(section_length - 2)) return PARSE_EXIF_ERROR_CORRUPT;
+  }
 }
 
 //
@@ -416,50 +526,14 @@ IFEntry parseIFEntry(const unsigned char *buf, const unsigned offs,
 int easyexif::EXIFInfo::parseFrom(const unsigned char *buf, unsigned len) {
   // Sanity check: all JPEG files start with 0xFFD8.
   if (!buf || len < 4) return PARSE_EXIF_ERROR_NO_JPEG;
-  if (buf[0] != 0xFF || buf[1] != 0xD8) return PARSE_EXIF_ERROR_NO_JPEG;
-
-  // Sanity check: some cameras pad the JPEG image with null bytes at the end.
-  // Normally, we should able to find the JPEG end marker 0xFFD9 at the end
-  // of the image, but not always. As long as there are null/0xFF bytes at the
-  // end of the image buffer, keep decrementing len until an 0xFFD9 is found,
-  // or some other bytes are. If the first non-zero/0xFF bytes from the end are
-  // not 0xFFD9, then we can be reasonably sure that the buffer is not a JPEG.
-  while (len > 2) {
-    if (buf[len - 1] == 0 || buf[len - 1] == 0xFF) {
-      len--;
-    } else {
-      if (buf[len - 1] != 0xD9 || buf[len - 2] != 0xFF) {
-        return PARSE_EXIF_ERROR_NO_JPEG;
-      } else {
-        break;
-      }
-    }
-  }
   clear();
 
-  // Scan for EXIF header (bytes 0xFF 0xE1) and do a sanity check by
-  // looking for bytes "Exif\0\0". The marker length data is in Motorola
-  // byte order, which results in the 'false' parameter to parse16().
-  // The marker has to contain at least the TIFF header, otherwise the
-  // EXIF data is corrupt. So the minimum length specified here has to be:
-  //   2 bytes: section size
-  //   6 bytes: "Exif\0\0" string
-  //   2 bytes: TIFF header (either "II" or "MM" string)
-  //   2 bytes: TIFF magic (short 0x2a00 in Motorola byte order)
-  //   4 bytes: Offset to first IFD
-  // =========
-  //  16 bytes
-  unsigned offs = 0;  // current offset into buffer
-  for (offs = 0; offs < len - 1; offs++)
-    if (buf[offs] == 0xFF && buf[offs + 1] == 0xE1) break;
-  if (offs + 4 > len) return PARSE_EXIF_ERROR_NO_EXIF;
-  offs += 2;
-  unsigned short section_length = parse_value<uint16_t>(buf + offs, false);
-  if (offs + section_length > len || section_length < 16)
-    return PARSE_EXIF_ERROR_CORRUPT;
-  offs += 2;
+  BufferStream stream(buf, len);
+  std::vector<unsigned char> segment;
+  const int result = readEXIFSegment(stream, segment);
+  if (result != PARSE_EXIF_SUCCESS) return result;
 
-  return parseFromEXIFSegment(buf + offs, len - offs);
+  return parseFromEXIFSegment(segment.data(), segment.size());
 }
 
 int easyexif::EXIFInfo::parseFrom(const string &data) {
@@ -508,7 +582,7 @@ int easyexif::EXIFInfo::parseFromEXIFSegment(const unsigned char *buf,
     return PARSE_EXIF_ERROR_CORRUPT;
   offs += 2;
   unsigned first_ifd_offset = parse_value<uint32_t>(buf + offs, alignIntel);
-  offs += first_ifd_offset - 4;
+  offs = resolveIFDOffset(tiff_header_start, first_ifd_offset, len);
   if (offs >= len) return PARSE_EXIF_ERROR_CORRUPT;
 
   // Now parsing the first Image File Directory (IFD0, for the main image).
@@ -517,9 +591,8 @@ int easyexif::EXIFInfo::parseFromEXIFSegment(const unsigned char *buf,
   // entries in the section. The last 4 bytes of the IFD contain an offset
   // to the next IFD, which means this IFD must contain exactly 6 + 12 * num
   // bytes of data.
-  if (offs + 2 > len) return PARSE_EXIF_ERROR_CORRUPT;
-  int num_entries = parse_value<uint16_t>(buf + offs, alignIntel);
-  if (offs + 6 + 12 * num_entries > len) return PARSE_EXIF_ERROR_CORRUPT;
+  int num_entries = parseIFDEntryCount(buf, len, alignIntel, offs);
+  if (num_entries < 0) return PARSE_EXIF_ERROR_CORRUPT;
   offs += 2;
   unsigned exif_sub_ifd_offset = len;
   unsigned gps_sub_ifd_offset = len;
@@ -572,12 +645,14 @@ int easyexif::EXIFInfo::parseFromEXIFSegment(const unsigned char *buf,
 
       case 0x8825:
         // GPS IFS offset
-        gps_sub_ifd_offset = tiff_header_start + result.data();
+        gps_sub_ifd_offset =
+            resolveIFDOffset(tiff_header_start, result.data(), len);
         break;
 
       case 0x8769:
         // EXIF SubIFD offset
-        exif_sub_ifd_offset = tiff_header_start + result.data();
+        exif_sub_ifd_offset =
+            resolveIFDOffset(tiff_header_start, result.data(), len);
         break;
     }
   }
@@ -586,10 +661,10 @@ int easyexif::EXIFInfo::parseFromEXIFSegment(const unsigned char *buf,
   // there. Note that it's possible that the EXIF SubIFD doesn't exist.
   // The EXIF SubIFD contains most of the interesting information that a
   // typical user might want.
-  if (exif_sub_ifd_offset + 4 <= len) {
+  if (exif_sub_ifd_offset < len) {
     offs = exif_sub_ifd_offset;
-    int num_entries = parse_value<uint16_t>(buf + offs, alignIntel);
-    if (offs + 6 + 12 * num_entries > len) return PARSE_EXIF_ERROR_CORRUPT;
+    int num_entries = parseIFDEntryCount(buf, len, alignIntel, offs);
+    if (num_entries < 0) return PARSE_EXIF_ERROR_CORRUPT;
     offs += 2;
     while (--num_entries >= 0) {
       IFEntry result =
@@ -704,7 +779,7 @@ int easyexif::EXIFInfo::parseFromEXIFSegment(const unsigned char *buf,
 
         case 0xa432:
           // Focal length and FStop.
-          if (result.format() == 5) {
+          if (result.format() == 5 && result.val_rational().size() >= 4) {
             this->LensInfo.FocalLengthMin = result.val_rational()[0];
             this->LensInfo.FocalLengthMax = result.val_rational()[1];
             this->LensInfo.FStopMin = result.val_rational()[2];
@@ -732,15 +807,18 @@ int easyexif::EXIFInfo::parseFromEXIFSegment(const unsigned char *buf,
 
   // Jump to the GPS SubIFD if it exists and parse all the information
   // there. Note that it's possible that the GPS SubIFD doesn't exist.
-  if (gps_sub_ifd_offset + 4 <= len) {
+  if (gps_sub_ifd_offset < len) {
     offs = gps_sub_ifd_offset;
-    int num_entries = parse_value<uint16_t>(buf + offs, alignIntel);
-    if (offs + 6 + 12 * num_entries > len) return PARSE_EXIF_ERROR_CORRUPT;
+    int num_entries = parseIFDEntryCount(buf, len, alignIntel, offs);
+    if (num_entries < 0) return PARSE_EXIF_ERROR_CORRUPT;
     offs += 2;
     while (--num_entries >= 0) {
       unsigned short tag, format;
       unsigned length, data;
       parseIFEntryHeader(buf + offs, alignIntel, tag, format, length, data);
+      // the rationals are stored at 'data', which has to be in the segment
+      const bool inBuffer = data < len - tiff_header_start &&
+                            length <= (len - tiff_header_start - data) / 8;
       switch (tag) {
         case 1:
           // GPS north or south
@@ -755,7 +833,7 @@ int easyexif::EXIFInfo::parseFromEXIFSegment(const unsigned char *buf,
 
         case 2:
           // GPS latitude
-          if ((format == 5 || format == 10) && length == 3) {
+          if ((format == 5 || format == 10) && length == 3 && inBuffer) {
             this->GeoLocation.LatComponents.degrees = parse_value<Rational>(
                 buf + data + tiff_header_start, alignIntel);
             this->GeoLocation.LatComponents.minutes = parse_value<Rational>(
@@ -785,7 +863,7 @@ int easyexif::EXIFInfo::parseFromEXIFSegment(const unsigned char *buf,
 
         case 4:
           // GPS longitude
-          if ((format == 5 || format == 10) && length == 3) {
+          if ((format == 5 || format == 10) && length == 3 && inBuffer) {
             this->GeoLocation.LonComponents.degrees = parse_value<Rational>(
                 buf + data + tiff_header_start, alignIntel);
             this->GeoLocation.LonComponents.minutes = parse_value<Rational>(
@@ -811,7 +889,7 @@ int easyexif::EXIFInfo::parseFromEXIFSegment(const unsigned char *buf,
 
         case 6:
           // GPS altitude
-          if ((format == 5 || format == 10)) {
+          if ((format == 5 || format == 10) && length >= 1 && inBuffer) {
             this->GeoLocation.Altitude = parse_value<Rational>(
                 buf + data + tiff_header_start, alignIntel);
             if (1 == this->GeoLocation.AltitudeRef) {
@@ -822,7 +900,7 @@ int easyexif::EXIFInfo::parseFromEXIFSegment(const unsigned char *buf,
 
         case 11:
           // GPS degree of precision (DOP)
-          if ((format == 5 || format == 10)) {
+          if ((format == 5 || format == 10) && length >= 1 && inBuffer) {
             this->GeoLocation.DOP = parse_value<Rational>(
                 buf + data + tiff_header_start, alignIntel);
           }
@@ -835,6 +913,230 @@ int easyexif::EXIFInfo::parseFromEXIFSegment(const unsigned char *buf,
   return PARSE_EXIF_SUCCESS;
 }
 
+namespace {
+
+// Same header checks as parseFromEXIFSegment(), 'ifd0_offset' is set to the
+// offset of IFD0 in the segment.
+int parseTIFFHeader(const unsigned char *buf, unsigned len, bool &alignIntel,
+                    unsigned &tiff_header_start, unsigned &ifd0_offset) {
+  unsigned offs = 0;
+  if (!buf || len < 6) return PARSE_EXIF_ERROR_NO_EXIF;
+  if (!std::equal(buf, buf + 6, "Exif\0\0")) return PARSE_EXIF_ERROR_NO_EXIF;
+  offs += 6;
+  if (offs + 8 > len) return PARSE_EXIF_ERROR_CORRUPT;
+  tiff_header_start = offs;
+  if (buf[offs] == 'I' && buf[offs + 1] == 'I')
+    alignIntel = true;
+  else if (buf[offs] == 'M' && buf[offs + 1] == 'M')
+    alignIntel = false;
+  else
+    return PARSE_EXIF_ERROR_UNKNOWN_BYTEALIGN;
+  offs += 2;
+  if (0x2a != parse_value<uint16_t>(buf + offs, alignIntel))
+    return PARSE_EXIF_ERROR_CORRUPT;
+  offs += 2;
+  unsigned first_ifd_offset = parse_value<uint32_t>(buf + offs, alignIntel);
+  offs = resolveIFDOffset(tiff_header_start, first_ifd_offset, len);
+  if (offs >= len) return PARSE_EXIF_ERROR_CORRUPT;
+  ifd0_offset = offs;
+  return PARSE_EXIF_SUCCESS;
+}
+
+// Looks up the sub-IFD pointer 'tag' in the IFD at 'offs'. 'sub_ifd_offset'
+// is set to 'len' if the tag is missing or points outside of the segment,
+// false is returned if the IFD does not fit in the segment.
+bool findSubIFD(const unsigned char *buf, unsigned len, bool alignIntel,
+                unsigned tiff_header_start, unsigned offs, unsigned short tag,
+                unsigned &sub_ifd_offset) {
+  int num_entries = parseIFDEntryCount(buf, len, alignIntel, offs);
+  if (num_entries < 0) return false;
+  offs += 2;
+  sub_ifd_offset = len;
+  while (--num_entries >= 0) {
+    if (parse_value<uint16_t>(buf + offs, alignIntel) == tag) {
+      sub_ifd_offset = resolveIFDOffset(
+          tiff_header_start, parse_value<uint32_t>(buf + offs + 8, alignIntel),
+          len);
+      break;
+    }
+    offs += 12;
+  }
+  return true;
+}
+}
+
+//
+// GPS only parsing function for an EXIF segment.
+//
+// PARAM: 'buf' start of the EXIF TIFF, which must be the bytes "Exif\0\0".
+// PARAM: 'len' length of buffer
+// PARAM: 'geoLocation' coordinates found, zero if the segment has none
+//
+int easyexif::EXIFInfo::parseGeoLocationFromEXIFSegment(
+    const unsigned char *buf, unsigned len, Geolocation_t &geoLocation) {
+  geoLocation.Latitude = 0;
+  geoLocation.Longitude = 0;
+  geoLocation.Altitude = 0;
+  geoLocation.AltitudeRef = 0;
+  geoLocation.DOP = 0;
+  geoLocation.LatComponents.degrees = 0;
+  geoLocation.LatComponents.minutes = 0;
+  geoLocation.LatComponents.seconds = 0;
+  geoLocation.LatComponents.direction = '?';
+  geoLocation.LonComponents = geoLocation.LatComponents;
+
+  bool alignIntel;
+  unsigned tiff_header_start, offs;
+  const int result =
+      parseTIFFHeader(buf, len, alignIntel, tiff_header_start, offs);
+  if (result != PARSE_EXIF_SUCCESS) return result;
+
+  // IFD0: only the GPS IFD pointer is looked at
+  unsigned gps_sub_ifd_offset;
+  if (!findSubIFD(buf, len, alignIntel, tiff_header_start, offs, 0x8825,
+                  gps_sub_ifd_offset))
+    return PARSE_EXIF_ERROR_CORRUPT;
+  if (gps_sub_ifd_offset == len) return PARSE_EXIF_SUCCESS;
+
+  // GPS IFD: the rationals are decoded straight from the buffer
+  offs = gps_sub_ifd_offset;
+  int num_entries = parseIFDEntryCount(buf, len, alignIntel, offs);
+  if (num_entries < 0) return PARSE_EXIF_ERROR_CORRUPT;
+  offs += 2;
+  while (--num_entries >= 0) {
+    unsigned short tag, format;
+    unsigned length, data;
+    parseIFEntryHeader(buf + offs, alignIntel, tag, format, length, data);
+    const unsigned char *values = buf + tiff_header_start + data;
+    const bool isRational = format == 5 || format == 10;
+    const bool inBuffer = data < len - tiff_header_start &&
+                          length <= (len - tiff_header_start - data) / 8;
+    switch (tag) {
+      case 1:
+        // GPS north or south
+        geoLocation.LatComponents.direction = *(buf + offs + 8);
+        break;
+
+      case 2:
+        // GPS latitude
+        if (isRational && length == 3 && inBuffer) {
+          geoLocation.LatComponents.degrees =
+              parse_value<Rational>(values, alignIntel);
+          geoLocation.LatComponents.minutes =
+              parse_value<Rational>(values + 8, alignIntel);
+          geoLocation.LatComponents.seconds =
+              parse_value<Rational>(values + 16, alignIntel);
+        }
+        break;
+
+      case 3:
+        // GPS east or west
+        geoLocation.LonComponents.direction = *(buf + offs + 8);
+        break;
+
+      case 4:
+        // GPS longitude
+        if (isRational && length == 3 && inBuffer) {
+          geoLocation.LonComponents.degrees =
+              parse_value<Rational>(values, alignIntel);
+          geoLocation.LonComponents.minutes =
+              parse_value<Rational>(values + 8, alignIntel);
+          geoLocation.LonComponents.seconds =
+              parse_value<Rational>(values + 16, alignIntel);
+        }
+        break;
+
+      case 5:
+        // GPS altitude reference (below or above sea level)
+        geoLocation.AltitudeRef = *(buf + offs + 8);
+        break;
+
+      case 6:
+        // GPS altitude
+        if (isRational && length >= 1 && inBuffer) {
+          geoLocation.Altitude = parse_value<Rational>(values, alignIntel);
+        }
+        break;
+
+      case 11:
+        // GPS degree of precision (DOP)
+        if (isRational && length >= 1 && inBuffer) {
+          geoLocation.DOP = parse_value<Rational>(values, alignIntel);
+        }
+        break;
+    }
+    offs += 12;
+  }
+
+  // the references may come in any order, the signs are applied at the end
+  if (geoLocation.LatComponents.direction == 0)
+    geoLocation.LatComponents.direction = '?';
+  if (geoLocation.LonComponents.direction == 0)
+    geoLocation.LonComponents.direction = '?';
+  geoLocation.Latitude = geoLocation.LatComponents.degrees +
+                         geoLocation.LatComponents.minutes / 60 +
+                         geoLocation.LatComponents.seconds / 3600;
+  if ('S' == geoLocation.LatComponents.direction)
+    geoLocation.Latitude = -geoLocation.Latitude;
+  geoLocation.Longitude = geoLocation.LonComponents.degrees +
+                          geoLocation.LonComponents.minutes / 60 +
+                          geoLocation.LonComponents.seconds / 3600;
+  if ('W' == geoLocation.LonComponents.direction)
+    geoLocation.Longitude = -geoLocation.Longitude;
+  if (1 == geoLocation.AltitudeRef) geoLocation.Altitude = -geoLocation.Altitude;
+
+  return PARSE_EXIF_SUCCESS;
+}
+
+//
+// Capture time only parsing function for an EXIF segment.
+//
+// PARAM: 'buf' start of the EXIF TIFF, which must be the bytes "Exif\0\0".
+// PARAM: 'len' length of buffer
+// PARAM: 'dateTime' DateTimeOriginal as "YYYY:MM:DD HH:MM:SS", empty if the
+//        segment has none
+//
+int easyexif::EXIFInfo::parseDateTimeOriginalFromEXIFSegment(
+    const unsigned char *buf, unsigned len, char dateTime[20]) {
+  dateTime[0] = 0;
+
+  bool alignIntel;
+  unsigned tiff_header_start, offs;
+  const int result =
+      parseTIFFHeader(buf, len, alignIntel, tiff_header_start, offs);
+  if (result != PARSE_EXIF_SUCCESS) return result;
+
+  // IFD0: only the EXIF sub-IFD pointer is looked at
+  unsigned exif_sub_ifd_offset;
+  if (!findSubIFD(buf, len, alignIntel, tiff_header_start, offs, 0x8769,
+                  exif_sub_ifd_offset))
+    return PARSE_EXIF_ERROR_CORRUPT;
+  if (exif_sub_ifd_offset == len) return PARSE_EXIF_SUCCESS;
+
+  offs = exif_sub_ifd_offset;
+  int num_entries = parseIFDEntryCount(buf, len, alignIntel, offs);
+  if (num_entries < 0) return PARSE_EXIF_ERROR_CORRUPT;
+  offs += 2;
+  while (--num_entries >= 0) {
+    unsigned short tag, format;
+    unsigned length, data;
+    parseIFEntryHeader(buf + offs, alignIntel, tag, format, length, data);
+    if (tag == 0x9003) {
+      // ASCII string with its terminating NUL, always stored out of the entry
+      if (format == 2 && length >= 20 && data < len - tiff_header_start &&
+          len - tiff_header_start - data >= 20) {
+        std::copy(buf + tiff_header_start + data,
+                  buf + tiff_header_start + data + 19, dateTime);
+        dateTime[19] = 0;
+      }
+      break;
+    }
+    offs += 12;
+  }
+  return PARSE_EXIF_SUCCESS;
+}
+
+
 void easyexif::EXIFInfo::clear() {
   // Strings
   ImageDescription = "";
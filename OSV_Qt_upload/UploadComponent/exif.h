@@ -35,9 +35,23 @@
 #define __EXIF_H
 
 #include <string>
+#include <vector>
 
 namespace easyexif {
 
+//
+// Sequential source of JPEG data for EXIFInfo::readEXIFSegment(), so the
+// EXIF lookup can run over a file without loading it.
+//
+class EXIFStream {
+ public:
+  virtual ~EXIFStream() {}
+  // Reads up to 'len' bytes, returns the number of bytes read.
+  virtual unsigned read(unsigned char *buf, unsigned len) = 0;
+  // Skips 'len' bytes, returns false if the data ends before.
+  virtual bool skip(unsigned len) = 0;
+};
+
 //
 // Class responsible for storing and parsing EXIF information from a JPEG blob
 //
@@ -52,11 +66,35 @@ class EXIFInfo {
   int parseFrom(const unsigned char *data, unsigned length);
   int parseFrom(const std::string &data);
 
+  // Locates the EXIF segment by following the JPEG marker lengths from SOI up
+  // to the start of the image data (SOS). Only the marker headers and the EXIF
+  // segment itself are read, every other segment is skipped.
+  //
+  // RETURN:  PARSE_EXIF_SUCCESS with 'segment' starting with "Exif\0\0",
+  //          PARSE_EXIF_ERROR_NO_EXIF if the image data starts before it,
+  //          another PARSE_EXIF_ERROR_* code for malformed data
+  static int readEXIFSegment(EXIFStream &stream,
+                             std::vector<unsigned char> &segment);
+
   // Parsing function for an EXIF segment. This is used internally by parseFrom()
   // but can be called for special cases where only the EXIF section is
   // available (i.e., a blob starting with the bytes "Exif\0\0").
   int parseFromEXIFSegment(const unsigned char *buf, unsigned len);
 
+  // Parsing function for the GPS location only. It takes the same EXIF
+  // segment as parseFromEXIFSegment() but only walks IFD0 to the GPS IFD and
+  // decodes the GPS coordinates, without any heap allocation.
+  struct Geolocation_t;
+  static int parseGeoLocationFromEXIFSegment(const unsigned char *buf,
+                                             unsigned len,
+                                             Geolocation_t &geoLocation);
+
+  // Same as parseGeoLocationFromEXIFSegment() for DateTimeOriginal, copied
+  // NUL terminated into 'dateTime' ("YYYY:MM:DD HH:MM:SS").
+  static int parseDateTimeOriginalFromEXIFSegment(const unsigned char *buf,
+                                                  unsigned len,
+                                                  char dateTime[20]);
+
   // Set all data members to default values.
   void clear();
 
@@ -0,0 +1,127 @@
+#include "exifbatch.h"
+#include "directoryscanner.h"
+#include "scancache.h"
+#include <QFileInfo>
+#include <QtConcurrent>
+
+static const int kDateTimeSize = sizeof(PhotoInfo::dateTimeOriginal);
+
+/*
+ * Map functor filling the rows of one chunk, the columns are resized before the workers start.
+ */
+struct ExtractChunk
+{
+    ExtractChunk(ExifBatchResult& result, ScanCache* cache, ScanProgress* progress)
+        : m_paths(result.paths)
+        , m_lat(result.lat.data())
+        , m_lng(result.lng.data())
+        , m_size(result.size.data())
+        , m_dateTimeOriginal(result.dateTimeOriginal.data())
+        , m_status(result.status.data())
+        , m_cache(cache)
+        , m_progress(progress)
+    {
+    }
+
+    void operator()(const int& first) const
+    {
+        const int last = qMin(first + kExifBatchChunk, m_paths.size());
+        for (int index = first; index < last; ++index)
+        {
+            extractRow(index);
+        }
+    }
+
+    void extractRow(const int index) const
+    {
+        PhotoInfo info;
+        bool      isValid   = false;
+        bool      isSkipped = m_progress && m_progress->isCancelled.load();
+        if (!isSkipped)
+        {
+            const QFileInfo fileInfo(m_paths.at(index));
+            if (!m_cache || !m_cache->findPhoto(fileInfo, info, isValid))
+            {
+                isValid = Photo::readPhotoInfo(fileInfo.filePath(), info);
+                if (m_cache)
+                {
+                    m_cache->insertPhoto(fileInfo, info, isValid);
+                }
+            }
+        }
+
+        char* dateTimeOriginal = m_dateTimeOriginal + index * kDateTimeSize;
+        if (isValid)
+        {
+            m_lat[index]  = info.lat;
+            m_lng[index]  = info.lng;
+            m_size[index] = info.size;
+            qstrncpy(dateTimeOriginal, info.dateTimeOriginal, kDateTimeSize);
+        }
+        else
+        {
+            m_lat[index]        = 0;
+            m_lng[index]        = 0;
+            m_size[index]       = 0;
+            dateTimeOriginal[0] = 0;
+        }
+        m_status[index] = isSkipped ? ExifStatus::SKIPPED
+                                    : (isValid ? ExifStatus::VALID : ExifStatus::NO_LOCATION);
+
+        if (m_progress)
+        {
+            m_progress->scannedFiles.ref();
+        }
+    }
+
+    const QStringList& m_paths;
+    double*            m_lat;
+    double*            m_lng;
+    qint64*            m_size;
+    char*              m_dateTimeOriginal;
+    ExifStatus*        m_status;
+    ScanCache*         m_cache;
+    ScanProgress*      m_progress;
+};
+
+int ExifBatchResult::count() const
+{
+    return paths.size();
+}
+
+int ExifBatchResult::validCount() const
+{
+    return status.count(ExifStatus::VALID);
+}
+
+PhotoInfo ExifBatchResult::photoInfoAt(const int index) const
+{
+    PhotoInfo info;
+    info.path = paths.at(index);
+    info.size = size.at(index);
+    info.lat  = lat.at(index);
+    info.lng  = lng.at(index);
+    qstrncpy(info.dateTimeOriginal, dateTimeOriginal.constData() + index * kDateTimeSize,
+             kDateTimeSize);
+    return info;
+}
+
+ExifBatchResult ExifBatch::extract(const QStringList& paths, ScanCache* cache,
+                                   ScanProgress* progress)
+{
+    ExifBatchResult result;
+    result.paths = paths;
+    result.lat.resize(paths.size());
+    result.lng.resize(paths.size());
+    result.size.resize(paths.size());
+    result.dateTimeOriginal.resize(paths.size() * kDateTimeSize);
+    result.status.resize(paths.size());
+
+    QVector<int> chunks;
+    for (int first = 0; first < paths.size(); first += kExifBatchChunk)
+    {
+        chunks.append(first);
+    }
+    QtConcurrent::blockingMap(chunks, ExtractChunk(result, cache, progress));
+    return result;
+}
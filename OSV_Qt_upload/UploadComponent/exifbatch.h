@@ -0,0 +1,45 @@
+#ifndef EXIFBATCH_H
+#define EXIFBATCH_H
+
+#include "photo.h"
+#include "uploadcomponentconstants.h"
+#include <QByteArray>
+#include <QStringList>
+#include <QVector>
+
+class ScanCache;
+struct ScanProgress;
+
+/*
+ * EXIF data of a list of photos, one contiguous column per field.
+ * Row i of every column belongs to paths[i], rows of photos without a location are kept with
+ * their status so the columns stay aligned with the input.
+ */
+struct ExifBatchResult
+{
+    QStringList         paths;
+    QVector<double>     lat;
+    QVector<double>     lng;
+    QVector<qint64>     size;
+    QByteArray          dateTimeOriginal;  // 20 bytes per row, NUL terminated
+    QVector<ExifStatus> status;
+
+    int       count() const;
+    int       validCount() const;
+    PhotoInfo photoInfoAt(const int index) const;
+};
+
+/*
+ * Reads the location and the capture time of many photos at once.
+ * The rows are cut in chunks of kExifBatchChunk spread on the global thread pool, every worker
+ * writes its rows in place, so no object is created per photo.
+ */
+class ExifBatch
+{
+public:
+    // blocks until every row is filled, the progress counters are updated on the way
+    static ExifBatchResult extract(const QStringList& paths, ScanCache* cache = 0,
+                                   ScanProgress* progress = 0);
+};
+
+#endif  // EXIFBATCH_H
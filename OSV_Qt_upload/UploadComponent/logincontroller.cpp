@@ -137,31 +137,27 @@ void LoginController::requestAccessTokenFromOSV()
 {
     HTTPRequest* request = new HTTPRequest(NULL, new QNetworkAccessManager());
 
-    request->setHandlerFunc([=](QNetworkReply* reply) {
-        if (reply)
-        {
-            QByteArray data        = reply->readAll();
-            QString    string_data = QString::fromLatin1(data.data());
-            qDebug() << string_data;
+    request->setHandlerFunc([=](const HTTPResponse& response) {
+        QByteArray data        = response.body;
+        QString    string_data = QString::fromLatin1(data.data());
+        qDebug() << string_data;
 
-            QJsonObject json = OSVAPI::objectFromString(string_data);
-            if (!json.isEmpty())
+        QJsonObject json = OSVAPI::objectFromString(string_data);
+        if (!json.isEmpty())
+        {
+            QJsonObject   statusObj  = json["status"].toObject();
+            OSVStatusCode statusCode = (OSVStatusCode)statusObj["apiCode"].toString().toInt();
+            if (statusCode == OSVStatusCode::SUCCESS)
             {
-                QJsonObject   statusObj  = json["status"].toObject();
-                OSVStatusCode statusCode = (OSVStatusCode)statusObj["apiCode"].toString().toInt();
-                if (statusCode == OSVStatusCode::SUCCESS)
+                QJsonObject osvObj = json["osv"].toObject();
+                if (osvObj.contains("access_token"))
                 {
-                    QJsonObject osvObj = json["osv"].toObject();
-                    if (osvObj.contains("access_token"))
-                    {
-                        qDebug() << osvObj["access_token"].toString();
-                        m_accessToken = osvObj["access_token"].toString();
-                        setUserInfo();
-                    }
+                    qDebug() << osvObj["access_token"].toString();
+                    m_accessToken = osvObj["access_token"].toString();
+                    setUserInfo();
                 }
             }
         }
-        reply->deleteLater();
         delete request;
     });
 
@@ -1,75 +1,148 @@
 #include "metadata.h"
+#include "uploadcomponentconstants.h"
+#include <QDebug>
 #include <QFileInfo>
 #include <GZIP.h>
 
 Metadata::Metadata(const QString &filepath, QObject *parent)
     :   QObject(parent),
         m_path(filepath),
-        m_size(QFileInfo(filepath).size())
+        m_size(QFileInfo(filepath).size()),
+        m_hasTrackInfo(false)
 {
-    if(!filepath.isEmpty())
+}
+
+void Metadata::processVideoMetadata(double &lat, double &lng)
+{
+    // the track file is read only if the scan did not provide its information
+    if(!m_hasTrackInfo)
     {
-        m_decompressPath = filepath;
-        m_decompressPath.chop(3);
-        GZIP::decompress(filepath, m_decompressPath);
+        TrackInfo info;
+        if(!readTrackInfo(m_path, info))
+        {
+            return;
+        }
+        setTrackInfo(info);
     }
+
+    lat = m_trackInfo.lat;
+    lng = m_trackInfo.lng;
 }
 
-void Metadata::processVideoMetadata(double &lat, double &lng)
+void Metadata::setTrackInfo(const TrackInfo &info)
 {
-    QFile metafile(m_decompressPath);
-    if(metafile.open(QIODevice::ReadOnly | QIODevice::Text))
+    m_trackInfo       = info;
+    m_platformName    = info.platformName;
+    m_platformVersion = info.platformVersion;
+    m_hasTrackInfo    = true;
+}
+
+/*
+ * Reads the platform from the first line of the track file and the first coordinates found.
+ * A compressed file is inflated in memory only up to the line holding them, a plain one is read
+ * as it is, nothing is written to disk.
+ * Does not touch any QObject, so it is safe to call from the scan workers.
+ */
+bool Metadata::readTrackInfo(const QString &filePath, TrackInfo &info)
+{
+    if(filePath.isEmpty())
     {
-        const QString firstLineString(metafile.readLine());
-        const QStringList firstLineFields(firstLineString.split(";"));
+        return false;
+    }
 
-        if(!firstLineFields.count() || firstLineFields.count() < 2)
+    info.lat = 0;
+    info.lng = 0;
+    const bool isCompressed = filePath.endsWith(".gz");
+    GZIPLineReader reader(filePath);
+    QFile plainFile(filePath);
+    const auto readLine = [&](QByteArray &line) {
+        if(isCompressed)
         {
-            return;
+            return reader.readLine(line);
+        }
+        if(plainFile.atEnd())
+        {
+            return false;
         }
-        else
+        line = plainFile.readLine();
+        while(line.endsWith('\n') || line.endsWith('\r'))
         {
-            m_platformName    = firstLineFields[0];
-            m_platformVersion = firstLineFields[1];
+            line.chop(1);
         }
+        return true;
+    };
 
-        bool foundCoordinates(false);
-        while (!metafile.atEnd() && !foundCoordinates)
+    QByteArray line;
+    const bool isOpen = isCompressed ? reader.open() : plainFile.open(QIODevice::ReadOnly);
+    if(!isOpen || !readLine(line))
+    {
+        return false;
+    }
+
+    const QList<QByteArray> firstLineFields(line.split(';'));
+
+    if(!firstLineFields.count() || firstLineFields.count() < 2)
+    {
+        return false;
+    }
+    else
+    {
+        info.platformName    = QString::fromUtf8(firstLineFields[0]);
+        info.platformVersion = QString::fromUtf8(firstLineFields[1]);
+    }
+
+    bool foundCoordinates(false);
+    while (!foundCoordinates && readLine(line))
+    {
+        const QList<QByteArray> fields(line.split(';'));
+
+        // first lat & lng found for the request of a new sequence
+        if(fields.count() > 14)
         {
-            const QString lineString(metafile.readLine());
-            const QStringList fields(lineString.split(";"));
+            if(!fields[1].isEmpty())
+            {
+                info.lng = fields[1].toDouble();
+            }
+
+            if(!fields[2].isEmpty())
+            {
+                info.lat = fields[2].toDouble();
+            }
 
-            // first lat & lng found for the request of a new sequence
-            if(fields.count() > 14)
+            if(info.lat && info.lng)
             {
-                if(!fields[1].isEmpty())
-                {
-                    lng = fields[1].toDouble();
-                }
-
-                if(!fields[2].isEmpty())
-                {
-                    lat = fields[2].toDouble();
-                }
-
-                if(lat && lng)
-                {
-                    foundCoordinates = true;
-                }
+                foundCoordinates = true;
             }
         }
     }
-    metafile.close();
+    return true;
 }
 
-QString Metadata::getPath()
+/*
+ * The upload takes a compressed track only, a plain track is compressed next to it once its
+ * sequence is about to be created. Runs on the thread of the upload engine.
+ */
+bool Metadata::compressTrack()
 {
-    return m_path;
+    if(m_path.isEmpty() || m_path.endsWith(".gz"))
+    {
+        return true;
+    }
+
+    const QString compressedPath = m_path + ".gz";
+    if(!GZIP::compressParallel(m_path, compressedPath, kTrackCompressionLevel))
+    {
+        qDebug() << "Can not compress track: " << m_path;
+        return false;
+    }
+    m_path = compressedPath;
+    m_size = QFileInfo(compressedPath).size();
+    return true;
 }
 
-QString Metadata::getDecompressPath()
+QString Metadata::getPath()
 {
-    return m_decompressPath;
+    return m_path;
 }
 
 long long Metadata::getSize()
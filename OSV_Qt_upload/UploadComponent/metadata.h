@@ -3,25 +3,41 @@
 
 #include <QFile>
 
+/*
+ * Information read from the first lines of a track file, it can be filled on any thread.
+ */
+struct TrackInfo
+{
+    QString platformName;
+    QString platformVersion;
+    double  lat;
+    double  lng;
+};
+
 class Metadata : public QObject
 {
     Q_OBJECT
 public:
     explicit Metadata(const QString& filepath, QObject* parent = 0);
     void processVideoMetadata(double& lat, double& lng);
+    void setTrackInfo(const TrackInfo& info);
+    // compresses a plain track.txt into track.txt.gz and takes that path, true if it is compressed
+    bool compressTrack();
+
+    static bool readTrackInfo(const QString& filePath, TrackInfo& info);
 
     QString   getPath();
-    QString   getDecompressPath();
     long long getSize();
     QString   getPlatformName();
     QString   getPlatformVersion();
 
 private:
     QString   m_path;
-    QString   m_decompressPath;
     QString   m_platformName;
     QString   m_platformVersion;
     long long m_size;
+    TrackInfo m_trackInfo;
+    bool      m_hasTrackInfo;
 };
 
 #endif  // METADATA_H
@@ -3,6 +3,10 @@
 #include <QCoreApplication>
 #include <QDir>
 #include <QFile>
+#include <QHash>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QTextStream>
 #include <QtAlgorithms>
 #include <QtCore/QVariant>
 
@@ -22,8 +26,21 @@ PersistentController::PersistentController(QObject* parent)
     : QObject(parent)
     , m_saveFilePath(getCurrentFolder().path() + "/save.json")
     ,  // path declared as const member to make sure that QApplication object is initialized
-    m_sequences(new QQmlObjectListModel<PersistentSequence>(this))
+    m_journalFilePath(getCurrentFolder().path() + "/save.journal")
+    , m_journalRecords(0)
+    , m_isUploading(false)
+    , m_mutex(QMutex::Recursive)
+    , m_sequences(new QQmlObjectListModel<PersistentSequence>(this))
+    , m_isScanning(false)
+    , m_scannedFiles(0)
+    , m_filesToScan(0)
+    , m_directoryScanner(new DirectoryScanner(this))
+    , m_scanCache(new ScanCache(getCurrentFolder().path() + "/scan.cache"))
 {
+    connect(m_directoryScanner, SIGNAL(progressChanged(int, int)), this,
+            SLOT(onScanProgress(int, int)));
+    connect(m_directoryScanner, SIGNAL(finished(QList<ScannedDirectory>, bool)), this,
+            SLOT(onScanFinished(QList<ScannedDirectory>, bool)));
     reset();
 }
 
@@ -33,22 +50,27 @@ void PersistentController::reset()
     setTotalSize(0);
     m_sequences->clear();
     m_persistentSequences.clear();
+    m_rescanSequences.clear();
     m_enteredDirPath.clear();
 
     load();
-    int seqIndex = 0;
+    m_scanCache->load();
+
+    // the folders of the unfinished sequences are scanned again in the background, the sequences
+    // are listed once they got their files back in onScanFinished()
+    QStringList rescanPaths;
     foreach (PersistentSequence* s, m_persistentSequences)
     {
         if (s->getSequenceStatus() != SequenceStatus::SUCCESS)
         {
-            m_enteredDirPath.append(s->getPath());
-            checkPaths(seqIndex);
-            if (s->size())
-            {
-                m_sequences->append(s);
-            }
+            m_rescanSequences.insert(s->getPath(), s);
+            rescanPaths.append(s->getPath());
         }
-        ++seqIndex;
+    }
+    if (!rescanPaths.isEmpty())
+    {
+        update_isScanning(true);
+        m_directoryScanner->start(rescanPaths, QSet<QString>(), false, m_scanCache);
     }
 }
 
@@ -79,147 +101,210 @@ void PersistentController::addPreviewPath(const QVariant& pathReceived)
     }
 }
 
+/*
+ * onDropped validates the files inside the folders dropped.
+ * It is called through a signal from dropping inside the area of the drag and drop region.
+ * The folders are scanned in the background, the ones that pass the test are then added to the
+ * model list with some of their information: folder name, size, files type
+ */
 void PersistentController::onDropped()
 {
+    if (m_isUploading)
+    {
+        m_enteredDirPath.clear();
+        return;
+    }
+
     foreach (PersistentSequence* s, m_persistentSequences)
     {
         if (m_enteredDirPath.contains(s->getPath()))
             m_enteredDirPath.removeOne(s->getPath());
     }
-    checkPaths();
+    startScan(m_enteredDirPath);
+    m_enteredDirPath.clear();
 }
 
-bool PersistentController::checkMetadata(const QString& path, PersistentSequence* sequence,
-                                         qint64& totalSize)
+void PersistentController::startScan(const QStringList& paths)
 {
-    QDirIterator itMetaData(path, QStringList() << "track.txt.gz"
-                                                << "track.txt",
-                            QDir::Files);
+    if (paths.isEmpty())
+    {
+        return;
+    }
 
-    while (itMetaData.hasNext())
+    // folders dropped during a scan are picked up once it is done
+    if (m_directoryScanner->isRunning())
     {
-        itMetaData.next();
-        if (itMetaData.fileInfo().size() < kGigaByte && itMetaData.fileInfo().suffix() == "gz")
-        {
-            sequence->setMetadata(new Metadata(itMetaData.filePath(), sequence));
-            totalSize += sequence->getMetadata()->getSize();
-            return true;
-        }
+        m_queuedScanPaths.append(paths);
+        return;
     }
-    sequence->setMetadata(new Metadata("", sequence));
-    return false;
+
+    QSet<QString> knownPaths;
+    foreach (PersistentSequence* s, m_persistentSequences)
+    {
+        knownPaths.insert(s->getPath());
+    }
+
+    update_isScanning(true);
+    m_directoryScanner->start(paths, knownPaths, true, m_scanCache);
+}
+
+void PersistentController::cancelScan()
+{
+    m_queuedScanPaths.clear();
+    m_directoryScanner->cancel();
+}
+
+void PersistentController::onScanProgress(int scannedFiles, int filesToScan)
+{
+    update_scannedFiles(scannedFiles);
+    update_filesToScan(filesToScan);
 }
 
-void PersistentController::checkPhotosExif(const QString& path, PersistentSequence* sequence,
-                                           qint64& totalSize)
+// merges the scanned folders on the GUI thread
+void PersistentController::onScanFinished(const QList<ScannedDirectory>& directories,
+                                          bool isCancelled)
 {
-    QDirIterator itPhotoFile(path, QStringList() << "*.jpg"
-                                                 << "*.jpeg",
-                             QDir::Files);
+    // the first scan after loading is the one of the saved sequences
+    if (!m_rescanSequences.isEmpty())
+    {
+        fillRescannedSequences(directories, isCancelled);
+    }
 
-    QList<Photo*> photos;
-    while (itPhotoFile.hasNext())
+    if (!isCancelled)
     {
-        itPhotoFile.next();
-        Photo* photo = new Photo(sequence);
+        bool isAdded = false;
+        foreach (const ScannedDirectory& directory, directories)
+        {
+            if (folderExist(directory.path))
+            {
+                continue;
+            }
+
+            PersistentSequence* sequence = new PersistentSequence(this);
+            if (fillSequence(sequence, directory))
+            {
+                QMutexLocker locker(&m_mutex);
+                m_persistentSequences.append(sequence);
+                m_sequences->append(sequence);
+                isAdded = true;
+            }
+            else
+            {
+                delete sequence;
+            }
+        }
 
-        if (photo->processPhoto(itPhotoFile.filePath()))
+        if (isAdded)
         {
-            photos.append(photo);
-            totalSize += photo->getSize();
+            save();
         }
+        m_scanCache->save();
+        calculateTotalInformation();
+        emit informationChanged();
     }
 
-    if (photos.size())
+    update_isScanning(false);
+    if (!m_queuedScanPaths.isEmpty())
     {
-        sequence->setPhotos(photos);
-        sequence->addPhotoInfo(path, totalSize);
-        addPersistentObject(sequence);
+        const QStringList paths(m_queuedScanPaths);
+        m_queuedScanPaths.clear();
+        startScan(paths);
     }
 }
 
-void PersistentController::checkVideos(const QString& path, PersistentSequence* sequence,
-                                       qint64& totalSize)
+// creates the files of a sequence from a scanned folder, returns false if it has none
+bool PersistentController::fillSequence(PersistentSequence* sequence,
+                                        const ScannedDirectory& directory)
 {
-    QDirIterator itVideoFile(path, QStringList() << "*.mp4", QDir::Files);
-
-    QList<Video*> videos;
-    long long     videoSize;
+    qint64 totalSize = 0;
+    sequence->setMetadata(new Metadata(directory.metadataPath, sequence));
+    if (directory.hasTrack)
+    {
+        sequence->getMetadata()->setTrackInfo(directory.track);
+    }
 
-    while (itVideoFile.hasNext())
+    if (!directory.metadataPath.isEmpty())
     {
-        itVideoFile.next();
-        videoSize = itVideoFile.fileInfo().size();
-        if (videoSize > 0 && videoSize < kGigaByte)
+        totalSize += sequence->getMetadata()->getSize();
+
+        QList<Video*> videos;
+        foreach (const QString& videoPath, directory.videoPaths)
         {
-            Video* video = new Video(itVideoFile.filePath(), sequence);
+            Video* video = new Video(videoPath, sequence);
             videos.append(video);
-            totalSize += videoSize;
+            totalSize += video->getSize();
         }
+
+        if (videos.isEmpty())
+        {
+            return false;
+        }
+        qSort(videos.begin(), videos.end(), Video::lessThan);
+        sequence->setVideos(videos);
+        sequence->addVideoInfo(directory.path, totalSize);
+        return true;
     }
 
-    qSort(videos.begin(), videos.end(), Video::lessThan);
+    const ExifBatchResult& batch = directory.photos;
+    QList<Photo*>          photos;
+    for (int index = 0; index < batch.count(); ++index)
+    {
+        if (batch.status.at(index) != ExifStatus::VALID)
+        {
+            continue;
+        }
+        Photo* photo = new Photo(sequence);
+        photo->setInfo(batch.photoInfoAt(index));
+        photos.append(photo);
+        totalSize += batch.size.at(index);
+    }
 
-    if (videos.size())  // exists valid videos
+    if (photos.isEmpty())
     {
-        qSort(videos.begin(), videos.end(), Video::lessThan);
-        sequence->setVideos(videos);
-        sequence->addVideoInfo(path, totalSize);
-        addPersistentObject(sequence);
+        return false;
     }
+    sequence->setPhotos(photos);
+    sequence->addPhotoInfo(directory.path, totalSize);
+    return true;
 }
 
 /*
- * onDroppedArea validates the files inside the folders dropped.
- * It is called through a signal from dropping inside the area of the drag and drop region.
- * The folders that passes the test are then added to the model list with some of their information:
- * folder name, size, files type
- * This function is declared as a public slot.
+ * Gives the saved sequences the files of their scanned folders and lists the ones that have files.
+ * A cancelled scan may have parsed a folder partly, which would shift the indexes of the sent
+ * flags: its sequences stay empty and out of the list, they are scanned again at the next start.
  */
-void PersistentController::checkPaths(const int index)
+void PersistentController::fillRescannedSequences(const QList<ScannedDirectory>& directories,
+                                                  bool isCancelled)
 {
-    int            i;
-    QList<QString> queue;
-    for (i = 0; i < m_enteredDirPath.size(); i++)
+    QMutexLocker locker(&m_mutex);
+    if (!isCancelled)
     {
-        queue.push_back(m_enteredDirPath.at(i));
-        while (!queue.empty())
+        foreach (const ScannedDirectory& directory, directories)
         {
-            QString front = queue.takeFirst();
-
-            PersistentSequence* validSequence(nullptr);
-            if (index == -1)
-                validSequence = new PersistentSequence(this);
-            else
-                validSequence = m_persistentSequences.at(index);
-
-            qint64 totalSize = 0;
-
-            if (!checkMetadata(front, validSequence, totalSize))
+            PersistentSequence* sequence = m_rescanSequences.value(directory.path, nullptr);
+            if (sequence)
             {
-                checkPhotosExif(front, validSequence, totalSize);
-            }
-            else
-            {
-                checkVideos(front, validSequence, totalSize);
-            }
-
-            QDirIterator itDir(front, QDir::Dirs | QDir::NoDotAndDotDot);
-            while (itDir.hasNext())  // search for sub directories
-            {
-                itDir.next();
-                if (!folderExist(itDir.filePath()))
-                {
-                    queue.push_back(itDir.filePath());
-                }
+                fillSequence(sequence, directory);
             }
         }
     }
 
-    calculateTotalInformation();
-    emit informationChanged();
-
-    m_enteredDirPath.clear();
+    foreach (PersistentSequence* s, m_persistentSequences)
+    {
+        if (!m_rescanSequences.contains(s->getPath()))
+        {
+            continue;
+        }
+        if (!s->getMetadata())
+        {
+            s->setMetadata(new Metadata("", s));
+        }
+        if (s->size())
+        {
+            m_sequences->append(s);
+        }
+    }
+    m_rescanSequences.clear();
 }
 
 /*
@@ -249,6 +334,7 @@ bool PersistentController::folderExist(const QString& filepath)
 
 void PersistentController::calculateTotalInformation()
 {
+    QMutexLocker locker(&m_mutex);
     qint64 sum     = 0;
     int    noFiles = 0;
     foreach (PersistentSequence* s, m_persistentSequences)
@@ -259,6 +345,7 @@ void PersistentController::calculateTotalInformation()
             noFiles += s->filesNo();
         }
     }
+    locker.unlock();
     setTotalFiles(noFiles);
     setTotalSize(sum);
 }
@@ -271,6 +358,12 @@ void PersistentController::onFileDialogButton(const QVariant& pathReceived)
 
 void PersistentController::removeFolders(const QList<QVariant> indexes)
 {
+    if (m_isUploading)
+    {
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
     for (int index = indexes.count() - 1; index >= 0; --index)
     {
         int indexToRemove = indexes[index].toInt();
@@ -278,6 +371,7 @@ void PersistentController::removeFolders(const QList<QVariant> indexes)
         m_sequences->remove(indexToRemove);
     }
     save();
+    locker.unlock();
     calculateTotalInformation();
     emit informationChanged();
 }
@@ -285,6 +379,7 @@ void PersistentController::removeFolders(const QList<QVariant> indexes)
 // add persistent object
 void PersistentController::addPersistentObject(PersistentSequence* sequence)
 {
+    QMutexLocker locker(&m_mutex);
     if (!m_persistentSequences.contains(sequence))
     {
         m_persistentSequences.append(sequence);
@@ -296,6 +391,7 @@ void PersistentController::addPersistentObject(PersistentSequence* sequence)
 // update information of an already existing object
 void PersistentController::updatePersistentObject(PersistentSequence* sequence)
 {
+    QMutexLocker locker(&m_mutex);
     if (m_persistentSequences.contains(sequence))
     {
         int index = findIndex(sequence);
@@ -304,15 +400,48 @@ void PersistentController::updatePersistentObject(PersistentSequence* sequence)
     }
 }
 
+/*
+ * Records an uploaded file without rewriting the whole progress file.
+ * A line is appended to the journal next to save.json, the journal is folded into save.json once
+ * it grows past kJournalCompactThreshold records or when a sequence changes its status.
+ */
+void PersistentController::markFileSent(PersistentSequence* sequence, const int fileIndex)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_persistentSequences.contains(sequence))
+    {
+        return;
+    }
+
+    // the path identifies the sequence, indexes change when folders are removed
+    if (!appendJournalRecord(QString::number(fileIndex) + " " + sequence->getPath() + "\n") ||
+        m_journalRecords >= kJournalCompactThreshold)
+    {
+        save();
+    }
+}
+
+QMutex* PersistentController::mutex()
+{
+    return &m_mutex;
+}
+
+void PersistentController::setIsUploading(const bool isUploading)
+{
+    m_isUploading = isUploading;
+}
+
 PersistentSequence* PersistentController::getElement(const int index)
 {
-    if (index < m_persistentSequences.size())
+    QMutexLocker locker(&m_mutex);
+    if (index >= 0 && index < m_persistentSequences.size())
         return m_persistentSequences.at(index);
     return nullptr;
 }
 
 QList<PersistentSequence*> PersistentController::getPersistentSequences()
 {
+    QMutexLocker locker(&m_mutex);
     return m_persistentSequences;
 }
 
@@ -345,8 +474,9 @@ void PersistentController::write(QJsonObject& json)
 // save all sequences in a folder
 bool PersistentController::save()
 {
-    QFile saveFile(m_saveFilePath);
-    saveFile.remove();
+    QMutexLocker locker(&m_mutex);
+    // the snapshot replaces save.json only once it was written completely
+    QSaveFile saveFile(m_saveFilePath);
     if (!saveFile.open(QIODevice::WriteOnly))
     {
         qDebug() << "Can not open!";
@@ -358,11 +488,87 @@ bool PersistentController::save()
 
     QJsonDocument saveDoc(progressObject);
     saveFile.write(saveDoc.toJson());
-    saveFile.close();
+    if (!saveFile.commit())
+    {
+        qDebug() << "Can not save!";
+        return false;
+    }
+
+    // everything recorded in the journal is part of the snapshot now
+    clearJournal();
     qDebug() << "Saved!";
     return true;
 }
 
+bool PersistentController::appendJournalRecord(const QString& record)
+{
+    if (!m_journalFile.isOpen())
+    {
+        m_journalFile.setFileName(m_journalFilePath);
+        if (!m_journalFile.open(QIODevice::WriteOnly | QIODevice::Append))
+        {
+            qDebug() << "Can not open journal!";
+            return false;
+        }
+    }
+
+    const QByteArray line(record.toUtf8());
+    if (m_journalFile.write(line) != line.size() || !m_journalFile.flush())
+    {
+        qDebug() << "Can not write journal!";
+        return false;
+    }
+    ++m_journalRecords;
+    return true;
+}
+
+// applies the records written after the last snapshot, returns their count
+int PersistentController::replayJournal()
+{
+    QFile journalFile(m_journalFilePath);
+    if (!journalFile.open(QIODevice::ReadOnly))
+    {
+        return 0;
+    }
+
+    QHash<QString, PersistentSequence*> sequencesByPath;
+    foreach (PersistentSequence* s, m_persistentSequences)
+    {
+        sequencesByPath.insert(s->getPath(), s);
+    }
+
+    int        records = 0;
+    QTextStream journalStream(&journalFile);
+    journalStream.setCodec("UTF-8");
+    while (!journalStream.atEnd())
+    {
+        const QString line(journalStream.readLine());
+        const int     separator = line.indexOf(' ');
+        if (separator <= 0)
+        {
+            continue;  // incomplete record of an interrupted write
+        }
+
+        bool      isIndex   = false;
+        const int fileIndex = line.left(separator).toInt(&isIndex);
+        PersistentSequence* sequence = sequencesByPath.value(line.mid(separator + 1), nullptr);
+        if (isIndex && sequence)
+        {
+            sequence->setFileSentOnIndex(fileIndex);
+            ++records;
+        }
+    }
+    journalFile.close();
+    return records;
+}
+
+void PersistentController::clearJournal()
+{
+    m_journalFile.close();
+    QFile::remove(m_journalFilePath);
+    m_journalRecords = 0;
+}
+
 void PersistentController::read(const QJsonObject& json)
 {
     QJsonArray sequenceArray = json["sequences"].toArray();
@@ -396,14 +602,20 @@ bool PersistentController::load()
 
     m_persistentSequences.clear();
     read(loadDoc.object());
+    loadFile.close();
+
+    if (replayJournal())
+    {
+        save();
+    }
 
     qDebug() << "Loaded! " << QFileInfo(loadFile).absoluteFilePath();
-    loadFile.close();
     return true;
 }
 
 void PersistentController::resetStatusForUnsentSequenceFiles()
 {
+    QMutexLocker locker(&m_mutex);
     foreach (PersistentSequence* s, m_persistentSequences)
     {
         s->resetStatusForUnsentFiles();
@@ -414,6 +626,8 @@ void PersistentController::resetProperties()
 {
     setTotalFiles(0);
     setTotalSize(0);
+
+    QMutexLocker locker(&m_mutex);
     m_sequences->clear();
 
     foreach (PersistentSequence* s, m_persistentSequences)
@@ -1,11 +1,16 @@
 #ifndef PERSISTENTCONTROLLER_H
 #define PERSISTENTCONTROLLER_H
 
+#include "directoryscanner.h"
 #include "jsonserializable.h"
+#include "scancache.h"
 #include "persistentsequence.h"
 #include "qqmlhelpers.h"
 #include "qqmlobjectlistmodel.h"
 #include <QDirIterator>
+#include <QFile>
+#include <QHash>
+#include <QMutex>
 #include <QObject>
 #include <QQueue>
 #include <QUrl>
@@ -16,11 +21,15 @@ class PersistentController : public QObject
     QML_READONLY_PROPERTY(int, totalFiles)
     QML_READONLY_PROPERTY(long long, totalSize)
     QML_OBJMODEL_PROPERTY(PersistentSequence, sequences)
+    QML_READONLY_PROPERTY(bool, isScanning)
+    QML_READONLY_PROPERTY(int, scannedFiles)
+    QML_READONLY_PROPERTY(int, filesToScan)
 public:
     explicit PersistentController(QObject* parent = 0);
 
     void addPersistentObject(PersistentSequence* sequence);
     void updatePersistentObject(PersistentSequence* sequence);
+    void markFileSent(PersistentSequence* sequence, const int fileIndex);
     void calculateTotalInformation();
     void reset();
 
@@ -31,14 +40,16 @@ public:
     void resetProperties();
     void resetStatusForUnsentSequenceFiles();
 
-private:
-    bool checkMetadata(const QString& path, PersistentSequence* sequence, qint64& totalSize);
-
-    void checkPhotosExif(const QString& path, PersistentSequence* sequence, qint64& totalSize);
+    // guards the list and the upload state of the sequences, the engine holds it while it works on them
+    QMutex* mutex();
+    // folders can not be added or removed while uploading, the engine refers to sequences by index
+    void setIsUploading(const bool isUploading);
 
-    void checkVideos(const QString& path, PersistentSequence* sequence, qint64& totalSize);
+private:
+    bool fillSequence(PersistentSequence* sequence, const ScannedDirectory& directory);
+    void fillRescannedSequences(const QList<ScannedDirectory>& directories, bool isCancelled);
 
-    void checkPaths(const int index = -1);
+    void startScan(const QStringList& paths);
 
     QString convertFolderPath(const QString& folderPath);
     bool folderExist(const QString& filepath);
@@ -46,6 +57,9 @@ private:
     void read(const QJsonObject& json);
     bool save();
     bool load();
+    bool appendJournalRecord(const QString& record);
+    int  replayJournal();
+    void clearJournal();
 
     // setters
     void setTotalFiles(const int totalFiles);
@@ -53,8 +67,19 @@ private:
 
 private:
     QStringList                m_enteredDirPath;
+    QStringList                m_queuedScanPaths;
+    // unfinished sequences loaded from save.json, by path, until their folders are scanned again
+    QHash<QString, PersistentSequence*> m_rescanSequences;
+    DirectoryScanner*          m_directoryScanner;
+    QSharedPointer<ScanCache>  m_scanCache;
     QList<PersistentSequence*> m_persistentSequences;
     const QString              m_saveFilePath;
+    const QString              m_journalFilePath;
+    QFile                      m_journalFile;
+    int                        m_journalRecords;
+    bool                       m_isUploading;
+    // the upload engine changes the sequences and records its progress from its own thread
+    QMutex                     m_mutex;
 
 signals:
     void informationChanged();
@@ -65,6 +90,11 @@ public slots:
     Q_INVOKABLE void addPreviewPath(const QVariant& pathReceived);
     Q_INVOKABLE void onDropped();
     Q_INVOKABLE void onExitedDropArea();
+    Q_INVOKABLE void cancelScan();
+
+private slots:
+    void onScanProgress(int scannedFiles, int filesToScan);
+    void onScanFinished(const QList<ScannedDirectory>& directories, bool isCancelled);
 };
 
 #endif  // PERSISTENTCONTROLLER_H
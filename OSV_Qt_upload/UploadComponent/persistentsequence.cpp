@@ -1,6 +1,37 @@
 #include "persistentsequence.h"
 #include <QFileInfo>
 
+/*
+ * The sent flags are saved as base64 of the bits packed 8 per byte, lowest bit first,
+ * together with the number of flags ("sentBits" and "sentCount").
+ */
+static QString packSentFlags(const QBitArray& flags)
+{
+    QByteArray packed((flags.size() + 7) / 8, 0);
+    for (int index = 0; index < flags.size(); ++index)
+    {
+        if (flags.testBit(index))
+        {
+            packed[index / 8] = (char)(packed.at(index / 8) | (1 << (index % 8)));
+        }
+    }
+    return QString::fromLatin1(packed.toBase64());
+}
+
+static QBitArray unpackSentFlags(const QString& encoded, const int count)
+{
+    const QByteArray packed(QByteArray::fromBase64(encoded.toLatin1()));
+    QBitArray        flags(qMin(count, packed.size() * 8));
+    for (int index = 0; index < flags.size(); ++index)
+    {
+        if (packed.at(index / 8) & (1 << (index % 8)))
+        {
+            flags.setBit(index);
+        }
+    }
+    return flags;
+}
+
 PersistentSequence::PersistentSequence(QObject* parent)
     : JsonSerializable(parent)
     , m_sequenceId(-1)
@@ -11,7 +42,8 @@ PersistentSequence::PersistentSequence(QObject* parent)
     , m_name("")
     , m_type(SequenceType::NONE)
     , m_status(SequenceStatus::AVAILABLE)
-    , m_filesSentIndex(new QVector<bool>())
+    , m_sentFilesCount(0)
+    , m_pendingFilesValid(false)
 {
 }
 
@@ -35,11 +67,11 @@ void PersistentSequence::addPhotoInfo(const QString& path, const qint64& totalSi
     setSize(totalSize);
     m_type = SequenceType::PHOTO;
 
-    if (m_filesSentIndex->isEmpty())
+    if (m_filesSent.isEmpty())
     {
-        m_filesSentIndex->reserve(m_photos.size());
-        m_filesSentIndex->fill(0, m_photos.size());
+        m_filesSent.resize(m_photos.size());
     }
+    m_pendingFilesValid = false;
 }
 
 void PersistentSequence::addVideoInfo(const QString& path, const qint64& totalSize)
@@ -49,11 +81,12 @@ void PersistentSequence::addVideoInfo(const QString& path, const qint64& totalSi
     setSize(totalSize);
     m_type = SequenceType::VIDEO;
 
-    if (m_filesSentIndex->isEmpty())
+    if (m_filesSent.isEmpty())
     {
-        m_filesSentIndex->reserve(m_videos.count());
-        m_filesSentIndex->fill(0, m_videos.count());
+        m_filesSent.resize(m_videos.count());
     }
+    m_pendingFilesValid = false;
+
     double lat(0), lng(0);
     m_metadata->processVideoMetadata(lat, lng);
     m_lat = lat;
@@ -75,12 +108,8 @@ void PersistentSequence::write(QJsonObject& jsonObj)
     {
         jsonObj["metadata"] = m_metadata->getPath();
     }
-    QString strSentIndex;
-    foreach (bool index, *m_filesSentIndex)
-    {
-        strSentIndex += QString::number(index);
-    }
-    jsonObj["sentIndex"] = strSentIndex;
+    jsonObj["sentBits"]  = packSentFlags(m_filesSent);
+    jsonObj["sentCount"] = m_filesSent.size();
 }
 
 void PersistentSequence::read(const QJsonObject& jsonObj)
@@ -109,23 +138,58 @@ void PersistentSequence::read(const QJsonObject& jsonObj)
         this->m_metadata = new Metadata(jsonObj["metadata"].toString(), this);
     }
 
-    if (jsonObj.contains("sentIndex"))
+    if (jsonObj.contains("sentBits"))
+    {
+        m_filesSent = unpackSentFlags(jsonObj["sentBits"].toString(), jsonObj["sentCount"].toInt());
+        m_sentFilesCount    = m_filesSent.count(true);
+        m_pendingFilesValid = false;
+    }
+    else if (jsonObj.contains("sentIndex"))  // save files written before "sentBits"
     {
-        m_filesSentIndex->clear();
         const QString strSentIndex(jsonObj["sentIndex"].toString());
-        foreach (QChar sentIndex, strSentIndex)
+        m_filesSent.fill(false, strSentIndex.size());
+        for (int index = 0; index < strSentIndex.size(); ++index)
         {
-            m_filesSentIndex->append(sentIndex.digitValue());
+            m_filesSent.setBit(index, strSentIndex.at(index).digitValue() == 1);
         }
+        m_sentFilesCount    = m_filesSent.count(true);
+        m_pendingFilesValid = false;
     }
 }
 
 int PersistentSequence::getIndexOfNextAvailablePhoto()
 {
-    for (int index = 0; index < m_photos.size(); ++index)
+    if (m_photos.isEmpty())
     {
-        if (m_filesSentIndex->at(index) == false &&
-            m_photos[index]->getStatus() == FileStatus::AVAILABLE)
+        return -1;
+    }
+    return takeNextAvailableFile();
+}
+
+int PersistentSequence::getIndexOfNextAvailableVideo()
+{
+    if (m_videos.isEmpty())
+    {
+        return -1;
+    }
+    return takeNextAvailableFile();
+}
+
+/*
+ * Returns the index of the next unsent file that is not uploading and removes it from the queue,
+ * the caller is expected to start its upload or hand it back with releaseFile().
+ */
+int PersistentSequence::takeNextAvailableFile()
+{
+    if (!m_pendingFilesValid)
+    {
+        rebuildPendingFiles();
+    }
+
+    while (!m_pendingFiles.isEmpty())
+    {
+        const int index = m_pendingFiles.dequeue();
+        if (!m_filesSent.testBit(index) && fileStatus(index) == FileStatus::AVAILABLE)
         {
             return index;
         }
@@ -133,11 +197,56 @@ int PersistentSequence::getIndexOfNextAvailablePhoto()
     return -1;
 }
 
+void PersistentSequence::rebuildPendingFiles()
+{
+    m_pendingFiles.clear();
+    const int filesCount = qMin(qMax(m_photos.size(), m_videos.size()), m_filesSent.size());
+    for (int index = 0; index < filesCount; ++index)
+    {
+        if (!m_filesSent.testBit(index))
+        {
+            m_pendingFiles.enqueue(index);
+        }
+    }
+    m_pendingFilesValid = true;
+}
+
+// makes a file taken for upload available again, e.g. when its request could not be started
+void PersistentSequence::releaseFile(int index)
+{
+    setFileStatus(index, FileStatus::AVAILABLE);
+    if (m_pendingFilesValid && !m_filesSent.testBit(index))
+    {
+        m_pendingFiles.enqueue(index);
+    }
+}
+
+FileStatus PersistentSequence::fileStatus(int index) const
+{
+    if (index < m_photos.size())
+    {
+        return m_photos[index]->getStatus();
+    }
+    return m_videos[index]->getStatus();
+}
+
+void PersistentSequence::setFileStatus(int index, const FileStatus status)
+{
+    if (index < m_photos.size())
+    {
+        m_photos[index]->setStatus(status);
+    }
+    else if (index < m_videos.size())
+    {
+        m_videos[index]->setStatus(status);
+    }
+}
+
 void PersistentSequence::resetStatusForUnsentFiles()
 {
     for (int index = 0; index < m_videos.size(); ++index)
     {
-        if (m_filesSentIndex->at(index) == false &&
+        if (m_filesSent.testBit(index) == false &&
             m_videos[index]->getStatus() == FileStatus::BUSY)
         {
             m_videos[index]->setStatus(FileStatus::AVAILABLE);
@@ -146,42 +255,33 @@ void PersistentSequence::resetStatusForUnsentFiles()
 
     for (int index = 0; index < m_photos.size(); ++index)
     {
-        if (m_filesSentIndex->at(index) == false &&
+        if (m_filesSent.testBit(index) == false &&
             m_photos[index]->getStatus() == FileStatus::BUSY)
         {
             const FileStatus fileStatus = FileStatus::AVAILABLE;
             m_photos[index]->setStatus(fileStatus);
         }
     }
-}
-
-int PersistentSequence::getIndexOfNextAvailableVideo()
-{
-    for (int index = 0; index < m_videos.size(); ++index)
-    {
-        if (m_filesSentIndex->at(index) == false &&
-            m_videos[index]->getStatus() == FileStatus::AVAILABLE)
-        {
-            return index;
-        }
-    }
-    return -1;
+    m_pendingFilesValid = false;
 }
 
 bool PersistentSequence::areAllFilesSent()
 {
-    return qFind(m_filesSentIndex->begin(), m_filesSentIndex->end(), false) ==
-           m_filesSentIndex->end();
+    return m_sentFilesCount == m_filesSent.size();
 }
 
 bool PersistentSequence::isFileSent(int index)
 {
-    return m_filesSentIndex->at(index);
+    return m_filesSent.testBit(index);
 }
 
 void PersistentSequence::setFileSentOnIndex(int index)
 {
-    m_filesSentIndex->replace(index, true);
+    if (index >= 0 && index < m_filesSent.size() && !m_filesSent.testBit(index))
+    {
+        m_filesSent.setBit(index);
+        ++m_sentFilesCount;
+    }
 }
 
 void PersistentSequence::resetInformation()
@@ -190,6 +290,7 @@ void PersistentSequence::resetInformation()
     setFilesNo(0);
     m_photos.clear();
     m_videos.clear();
+    m_pendingFilesValid = false;
 }
 
 // Getters
@@ -307,12 +408,14 @@ void PersistentSequence::setLng(const float& lng)
 
 void PersistentSequence::setPhotos(const QList<Photo*> photos)
 {
-    m_photos = photos;
+    m_photos            = photos;
+    m_pendingFilesValid = false;
 }
 
 void PersistentSequence::setVideos(const QList<Video*> videos)
 {
-    m_videos = videos;
+    m_videos            = videos;
+    m_pendingFilesValid = false;
 }
 
 void PersistentSequence::setMetadata(Metadata* metadata)
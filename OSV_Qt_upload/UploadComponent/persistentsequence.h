@@ -5,9 +5,11 @@
 #include "metadata.h"
 #include "photo.h"
 #include "video.h"
+#include <QBitArray>
 #include <QDebug>
 #include <QJsonArray>
 #include <QJsonDocument>
+#include <QQueue>
 
 enum class SequenceStatus : int
 {
@@ -50,6 +52,7 @@ public:
 
     int  getIndexOfNextAvailablePhoto();
     int  getIndexOfNextAvailableVideo();
+    void releaseFile(int index);
     void resetStatusForUnsentFiles();
     void resetInformation();
 
@@ -94,7 +97,17 @@ signals:
 
 private:
     void setFolderPathAndName(const QString& folderPath);
-    QVector<bool>* m_filesSentIndex;
+    int  takeNextAvailableFile();
+    void rebuildPendingFiles();
+    FileStatus fileStatus(int index) const;
+    void       setFileStatus(int index, const FileStatus status);
+
+    QBitArray      m_filesSent;
+    int            m_sentFilesCount;
+    // indexes of files waiting for upload, entries of files sent or picked up meanwhile are
+    // skipped when taken, the queue is rebuilt after the files or their sent flags change
+    QQueue<int>    m_pendingFiles;
+    bool           m_pendingFilesValid;
 
     int            m_sequenceId;
     QString        m_path;
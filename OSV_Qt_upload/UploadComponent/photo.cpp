@@ -4,6 +4,33 @@
 #include <QFileInfo>
 #include <QDebug>
 
+/*
+ * Feeds the JPEG marker walker of easyexif from a file, skipped segments are seeked over.
+ */
+class FileExifStream : public easyexif::EXIFStream
+{
+public:
+    explicit FileExifStream(QFile &file)
+        : m_file(file)
+    {
+    }
+
+    unsigned read(unsigned char *buf, unsigned len)
+    {
+        const qint64 count = m_file.read((char*)buf, len);
+        return count > 0 ? (unsigned)count : 0;
+    }
+
+    bool skip(unsigned len)
+    {
+        const qint64 pos = m_file.pos() + len;
+        return pos <= m_file.size() && m_file.seek(pos);
+    }
+
+private:
+    QFile &m_file;
+};
+
 Photo::Photo(QObject *parent)
     : QObject(parent),
       m_path(""),
@@ -15,6 +42,30 @@ Photo::Photo(QObject *parent)
 }
 
 bool Photo::processPhoto(const QString &filePath)
+{
+    PhotoInfo info;
+    if(!readPhotoInfo(filePath, info))
+    {
+        return false;
+    }
+
+    setInfo(info);
+    return true;
+}
+
+void Photo::setInfo(const PhotoInfo &info)
+{
+    m_path = info.path;
+    m_size = info.size;
+    m_lat  = info.lat;
+    m_lng  = info.lng;
+}
+
+/*
+ * Reads the location of a photo, returns false if the photo has none.
+ * Does not touch any QObject, so it is safe to call from the scan workers.
+ */
+bool Photo::readPhotoInfo(const QString &filePath, PhotoInfo &info)
 {
     QFile file(filePath);
 
@@ -23,24 +74,35 @@ bool Photo::processPhoto(const QString &filePath)
         qDebug() << "Can not open photo for exif!";
         return false;
     }
-    const QByteArray buffer = file.readAll();
-
-    easyexif::EXIFInfo result;
-    result.parseFrom((const uchar*)buffer.constData(), buffer.size());
-    m_lat = result.GeoLocation.Latitude;
-    m_lng = result.GeoLocation.Longitude;
-
-    if(!m_lat || !m_lng)
+    // only the marker headers and the EXIF segment are read
+    easyexif::EXIFInfo::Geolocation_t geoLocation;
+    std::vector<unsigned char>        segment;
+    FileExifStream                    stream(file);
+    if(easyexif::EXIFInfo::readEXIFSegment(stream, segment) == PARSE_EXIF_SUCCESS)
     {
-        qDebug() << "Missing GeoLocation Args!";
-        return false;
+        // only the GPS tags and the capture time are decoded
+        easyexif::EXIFInfo::parseGeoLocationFromEXIFSegment(segment.data(), segment.size(),
+                                                            geoLocation);
+        easyexif::EXIFInfo::parseDateTimeOriginalFromEXIFSegment(segment.data(), segment.size(),
+                                                                 info.dateTimeOriginal);
     }
     else
     {
-        m_path = filePath;
+        geoLocation.Latitude  = 0;
+        geoLocation.Longitude = 0;
+        info.dateTimeOriginal[0] = 0;
+    }
+    info.lat = geoLocation.Latitude;
+    info.lng = geoLocation.Longitude;
+
+    if(!info.lat || !info.lng)
+    {
+        qDebug() << "Missing GeoLocation Args!";
+        return false;
     }
 
-    m_size = QFileInfo(filePath).size();
+    info.path = filePath;
+    info.size = file.size();
     return true;
 }
 
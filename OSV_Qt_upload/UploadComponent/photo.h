@@ -3,6 +3,18 @@
 #include <QObject>
 #include <uploadcomponentconstants.h>
 
+/*
+ * Plain information read from a photo file, it can be filled on any thread.
+ */
+struct PhotoInfo
+{
+    QString   path;
+    long long size;
+    double    lat;
+    double    lng;
+    char      dateTimeOriginal[20];  // "YYYY:MM:DD HH:MM:SS", empty if missing
+};
+
 class Photo : public QObject
 {
     Q_OBJECT
@@ -10,6 +22,9 @@ public:
     explicit Photo(QObject* parent = 0);
 
     bool processPhoto(const QString& filePath);
+    void setInfo(const PhotoInfo& info);
+
+    static bool readPhotoInfo(const QString& filePath, PhotoInfo& info);
 
     static bool lessThan(Photo* p1, Photo* p2);
 
@@ -0,0 +1,114 @@
+#include "rateestimator.h"
+#include <QtMath>
+
+RateEstimator::RateEstimator(const qint64 window)
+    : m_window(window)
+    , m_activeTime(0)
+    , m_isRunning(false)
+    , m_pendingBytes(0)
+    , m_totalBytes(0)
+    , m_lastUpdate(0)
+    , m_smoothedRate(0)
+{
+}
+
+void RateEstimator::start()
+{
+    reset();
+    resume();
+}
+
+void RateEstimator::pause()
+{
+    if (!m_isRunning)
+    {
+        return;
+    }
+    update();
+    m_activeTime += m_clock.elapsed();
+    m_isRunning = false;
+}
+
+void RateEstimator::resume()
+{
+    if (m_isRunning)
+    {
+        return;
+    }
+    m_clock.start();
+    m_isRunning = true;
+}
+
+void RateEstimator::reset()
+{
+    m_activeTime = 0;
+    m_isRunning  = false;
+    m_pendingBytes = 0;
+    m_totalBytes   = 0;
+    m_lastUpdate   = 0;
+    m_smoothedRate = 0;
+}
+
+void RateEstimator::addBytes(const qint64 bytes)
+{
+    if (m_isRunning)
+    {
+        m_pendingBytes += bytes;
+    }
+}
+
+void RateEstimator::update()
+{
+    const qint64 now     = activeTime();
+    const qint64 elapsed = now - m_lastUpdate;
+    if (elapsed <= 0)
+    {
+        return;
+    }
+
+    m_totalBytes += m_pendingBytes;
+    if (now <= m_window)
+    {
+        m_smoothedRate = (double)m_totalBytes * 1000 / now;
+    }
+    else
+    {
+        // the weight of an update grows with the time it covers, updates may come at any pace
+        const double sampleRate = (double)m_pendingBytes * 1000 / elapsed;
+        const double alpha      = 1 - qExp(-(double)elapsed / m_window);
+        m_smoothedRate += alpha * (sampleRate - m_smoothedRate);
+    }
+
+    m_pendingBytes = 0;
+    m_lastUpdate   = now;
+}
+
+double RateEstimator::smoothedRate() const
+{
+    return m_smoothedRate;
+}
+
+double RateEstimator::averageRate() const
+{
+    return m_lastUpdate > 0 ? (double)m_totalBytes * 1000 / m_lastUpdate : 0;
+}
+
+int RateEstimator::remainingTime(const qint64 remainingBytes, const int remainingFiles,
+                                 const double rate, const int parallelFiles,
+                                 const int fileOverhead)
+{
+    if (rate <= 0)
+    {
+        return -1;
+    }
+
+    const double transferTime = qMax(remainingBytes, (qint64)0) / rate;
+    const double overheadTime =
+        (double)qMax(remainingFiles, 0) * fileOverhead / 1000 / qMax(parallelFiles, 1);
+    return qCeil(transferTime + overheadTime);
+}
+
+qint64 RateEstimator::activeTime() const
+{
+    return m_activeTime + (m_isRunning ? m_clock.elapsed() : 0);
+}
@@ -0,0 +1,52 @@
+#ifndef RATEESTIMATOR_H
+#define RATEESTIMATOR_H
+
+#include <QElapsedTimer>
+
+/*
+ * Throughput of the upload, measured on a millisecond clock that stops while the upload is paused.
+ * Bytes are added as the network layer reports them and folded into the rates by update():
+ * - the smoothed rate is an exponentially weighted moving average of the updates, with 'window' as
+ *   time constant; during the first window it is the average rate, so it does not start at the
+ *   spike of the first chunks,
+ * - the average rate covers the whole upload.
+ * Only bytes sent since start() count, files found already uploaded do not make the rates grow.
+ */
+class RateEstimator
+{
+public:
+    explicit RateEstimator(const qint64 window);
+
+    void start();
+    void pause();
+    void resume();
+    void reset();
+
+    void addBytes(const qint64 bytes);
+    void update();
+
+    // B/s
+    double smoothedRate() const;
+    double averageRate() const;
+
+    // seconds left for the bytes at 'rate', each file costing 'fileOverhead' ms of server time,
+    // spread over the files sent in parallel; -1 if there is no rate yet
+    static int remainingTime(const qint64 remainingBytes, const int remainingFiles,
+                             const double rate, const int parallelFiles, const int fileOverhead);
+
+private:
+    qint64 activeTime() const;
+
+    const qint64  m_window;
+    QElapsedTimer m_clock;
+    qint64        m_activeTime;  // ms spent running before the last pause
+    bool          m_isRunning;
+
+    qint64 m_pendingBytes;
+    qint64 m_totalBytes;
+    qint64 m_lastUpdate;
+
+    double m_smoothedRate;
+};
+
+#endif  // RATEESTIMATOR_H
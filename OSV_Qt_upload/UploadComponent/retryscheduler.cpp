@@ -0,0 +1,160 @@
+#include "retryscheduler.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QtGlobal>
+
+RetryScheduler::RetryScheduler(QObject* parent)
+    : QObject(parent)
+{
+    qsrand(QDateTime::currentMSecsSinceEpoch() & 0xFFFFFFFF);
+}
+
+RetryScheduler::~RetryScheduler()
+{
+    cancelAll();
+}
+
+/*
+ * Maps the answer of a finished request to the kind of failure it represents.
+ * Transport errors, requests aborted by the HTTPRequest watchdog included, and 5xx answers are
+ * transient, 690 is retried with a smaller budget, 401 means the token is no longer valid and any
+ * other rejection would fail the same way again.
+ */
+RequestError RetryScheduler::classifyError(const HTTPResponse& response,
+                                           const OSVStatusCode statusCode)
+{
+    if (statusCode == OSVStatusCode::SUCCESS || statusCode == OSVStatusCode::DUPLICATE)
+    {
+        return RequestError::NONE;
+    }
+
+    const int httpStatus = response.httpStatus;
+    if (httpStatus == 401 || statusCode == OSVStatusCode::BAD_LOGIN)
+    {
+        return RequestError::UNAUTHORIZED;
+    }
+
+    if (httpStatus >= 500)
+    {
+        return RequestError::SERVER;
+    }
+
+    if (response.error != QNetworkReply::NoError && httpStatus == 0)
+    {
+        return RequestError::NETWORK;
+    }
+
+    switch (statusCode)
+    {
+        case OSVStatusCode::UNEXPECTED_ERROR:
+            return RequestError::UNEXPECTED;
+        case OSVStatusCode::STATUS_INCORRECT:  // empty or unreadable answer
+        case OSVStatusCode::SUCCESS_SAVE_ERROR:
+            return RequestError::SERVER;
+        default:
+            break;
+    }
+
+    return RequestError::REJECTED;
+}
+
+bool RetryScheduler::isRetryable(const RequestError error)
+{
+    return error == RequestError::NETWORK || error == RequestError::SERVER ||
+           error == RequestError::UNEXPECTED;
+}
+
+QString RetryScheduler::retryKey(const RequestClass requestClass, const int sequenceIndex,
+                                 const int fileIndex)
+{
+    return QString::number((int)requestClass) + ":" + QString::number(sequenceIndex) + ":" +
+           QString::number(fileIndex);
+}
+
+RetryScheduler::RetryPolicy RetryScheduler::policy(const RequestClass requestClass)
+{
+    switch (requestClass)
+    {
+        case RequestClass::SEQUENCE:
+        case RequestClass::SEQUENCE_FINISHED:
+            return {kRetrySequenceBaseDelay, kRetryMaxDelay, kRetrySequenceMaxAttempts};
+        case RequestClass::VIDEO:
+            return {kRetryVideoBaseDelay, kRetryMaxDelay, kRetryFileMaxAttempts};
+        case RequestClass::PHOTO:
+        default:
+            return {kRetryPhotoBaseDelay, kRetryMaxDelay, kRetryFileMaxAttempts};
+    }
+}
+
+int RetryScheduler::backoffDelay(const RetryPolicy& policy, const int attempt) const
+{
+    qint64 delay = policy.baseDelay;
+    for (int i = 1; i < attempt && delay < policy.maxDelay; ++i)
+    {
+        delay *= 2;
+    }
+    delay = qMin(delay, (qint64)policy.maxDelay);
+
+    // "equal jitter": half of the delay is fixed, the other half random, so failed requests of
+    // the same burst do not come back to the server at the same moment
+    const qint64 half = delay / 2;
+    return half + (half > 0 ? qrand() % (half + 1) : 0);
+}
+
+bool RetryScheduler::schedule(const RequestClass requestClass, const QString& key,
+                              const RequestError error, std::function<void()> retryFunc)
+{
+    if (!isRetryable(error))
+    {
+        m_attempts.remove(key);
+        return false;
+    }
+
+    const RetryPolicy retryPolicy = policy(requestClass);
+    const int maxAttempts = error == RequestError::UNEXPECTED ? qMax(1, retryPolicy.maxAttempts / 2)
+                                                              : retryPolicy.maxAttempts;
+    const int attempt = m_attempts.value(key, 0) + 1;
+    if (attempt > maxAttempts)
+    {
+        qDebug() << "Retry budget exhausted for request " << key;
+        m_attempts.remove(key);
+        return false;
+    }
+    m_attempts.insert(key, attempt);
+
+    const int delay = backoffDelay(retryPolicy, attempt);
+    qDebug() << "Retry " << attempt << "/" << maxAttempts << " for request " << key << " in "
+             << delay << " ms";
+
+    QTimer* timer = new QTimer(this);
+    timer->setSingleShot(true);
+    connect(timer, &QTimer::timeout, this, [=]() {
+        m_pendingTimers.removeOne(timer);
+        timer->deleteLater();
+        retryFunc();
+    });
+    m_pendingTimers.append(timer);
+    timer->start(delay);
+    return true;
+}
+
+void RetryScheduler::succeeded(const QString& key)
+{
+    m_attempts.remove(key);
+}
+
+void RetryScheduler::cancelAll()
+{
+    foreach (QTimer* timer, m_pendingTimers)
+    {
+        timer->stop();
+        timer->deleteLater();
+    }
+    m_pendingTimers.clear();
+    m_attempts.clear();
+}
+
+int RetryScheduler::pendingRetries() const
+{
+    return m_pendingTimers.count();
+}
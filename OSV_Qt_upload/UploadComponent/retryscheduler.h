@@ -0,0 +1,59 @@
+#ifndef RETRYSCHEDULER_H
+#define RETRYSCHEDULER_H
+
+#include "httprequest.h"
+#include "uploadcomponentconstants.h"
+#include <QHash>
+#include <QObject>
+#include <QTimer>
+#include <functional>
+
+enum class RequestClass : int
+{
+    SEQUENCE          = 0,
+    SEQUENCE_FINISHED = 1,
+    PHOTO             = 2,
+    VIDEO             = 3
+};
+
+/*
+ * Schedules retries of failed OSV requests.
+ * Every request class has its own exponential backoff (with jitter) and a budget of attempts.
+ * Retries are queued on single shot timers, so a failure never blocks or re-enters the event loop.
+ */
+class RetryScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    explicit RetryScheduler(QObject* parent = 0);
+    ~RetryScheduler();
+
+    static RequestError classifyError(const HTTPResponse& response, const OSVStatusCode statusCode);
+    static bool isRetryable(const RequestError error);
+    static QString retryKey(const RequestClass requestClass, const int sequenceIndex,
+                            const int fileIndex = -1);
+
+    // returns false if the error is not retryable or the retry budget of the request is spent
+    bool schedule(const RequestClass requestClass, const QString& key, const RequestError error,
+                  std::function<void()> retryFunc);
+    void succeeded(const QString& key);
+    void cancelAll();
+
+    int pendingRetries() const;
+
+private:
+    struct RetryPolicy
+    {
+        int baseDelay;
+        int maxDelay;
+        int maxAttempts;
+    };
+
+    static RetryPolicy policy(const RequestClass requestClass);
+    int backoffDelay(const RetryPolicy& policy, const int attempt) const;
+
+    QHash<QString, int> m_attempts;
+    QList<QTimer*>      m_pendingTimers;
+};
+
+#endif  // RETRYSCHEDULER_H
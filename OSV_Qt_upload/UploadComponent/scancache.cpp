@@ -0,0 +1,167 @@
+#include "scancache.h"
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QSaveFile>
+
+static const quint32 kScanCacheMagic   = 0x4F535643;  // "OSVC"
+static const quint32 kScanCacheVersion = 2;
+
+ScanCache::ScanCache(const QString& filePath)
+    : m_filePath(filePath)
+{
+}
+
+bool ScanCache::load()
+{
+    QFile cacheFile(m_filePath);
+    if (!cacheFile.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+
+    QDataStream stream(&cacheFile);
+    stream.setVersion(QDataStream::Qt_5_6);
+
+    quint32 magic, version, count;
+    stream >> magic >> version >> count;
+    if (magic != kScanCacheMagic || version != kScanCacheVersion)
+    {
+        qDebug() << "Scan cache ignored, unknown format";
+        return false;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    m_entries.clear();
+    m_entries.reserve(count);
+    for (quint32 index = 0; index < count && stream.status() == QDataStream::Ok; ++index)
+    {
+        QString path;
+        Entry   entry;
+        stream >> path >> entry.size >> entry.modified >> entry.isValid >> entry.lat >> entry.lng >>
+            entry.dateTimeOriginal >> entry.platformName >> entry.platformVersion;
+        entry.isUsed = false;
+        if (stream.status() == QDataStream::Ok)
+        {
+            m_entries.insert(path, entry);
+        }
+    }
+    qDebug() << "Scan cache loaded: " << m_entries.size() << " files";
+    return true;
+}
+
+bool ScanCache::save()
+{
+    QMutexLocker locker(&m_mutex);
+    QSaveFile    cacheFile(m_filePath);
+    if (!cacheFile.open(QIODevice::WriteOnly))
+    {
+        qDebug() << "Can not open scan cache!";
+        return false;
+    }
+
+    quint32 count = 0;
+    for (QHash<QString, Entry>::const_iterator it = m_entries.constBegin();
+         it != m_entries.constEnd(); ++it)
+    {
+        count += it.value().isUsed;
+    }
+
+    QDataStream stream(&cacheFile);
+    stream.setVersion(QDataStream::Qt_5_6);
+    stream << kScanCacheMagic << kScanCacheVersion << count;
+    for (QHash<QString, Entry>::const_iterator it = m_entries.constBegin();
+         it != m_entries.constEnd(); ++it)
+    {
+        const Entry& entry = it.value();
+        if (entry.isUsed)
+        {
+            stream << it.key() << entry.size << entry.modified << entry.isValid << entry.lat
+                   << entry.lng << entry.dateTimeOriginal << entry.platformName
+                   << entry.platformVersion;
+        }
+    }
+    return cacheFile.commit();
+}
+
+bool ScanCache::findPhoto(const QFileInfo& fileInfo, PhotoInfo& info, bool& isValid)
+{
+    Entry entry;
+    if (!findEntry(fileInfo, entry))
+    {
+        return false;
+    }
+
+    info.path = fileInfo.filePath();
+    info.size = entry.size;
+    info.lat  = entry.lat;
+    info.lng  = entry.lng;
+    qstrncpy(info.dateTimeOriginal, entry.dateTimeOriginal.constData(),
+             sizeof(info.dateTimeOriginal));
+    isValid = entry.isValid;
+    return true;
+}
+
+void ScanCache::insertPhoto(const QFileInfo& fileInfo, const PhotoInfo& info, const bool isValid)
+{
+    Entry entry;
+    entry.isValid = isValid;
+    entry.lat     = isValid ? info.lat : 0;
+    entry.lng     = isValid ? info.lng : 0;
+    if (isValid)
+    {
+        entry.dateTimeOriginal = info.dateTimeOriginal;
+    }
+    insertEntry(fileInfo, entry);
+}
+
+bool ScanCache::findTrack(const QFileInfo& fileInfo, TrackInfo& info)
+{
+    Entry entry;
+    if (!findEntry(fileInfo, entry) || !entry.isValid)
+    {
+        return false;
+    }
+
+    info.platformName    = entry.platformName;
+    info.platformVersion = entry.platformVersion;
+    info.lat             = entry.lat;
+    info.lng             = entry.lng;
+    return true;
+}
+
+void ScanCache::insertTrack(const QFileInfo& fileInfo, const TrackInfo& info)
+{
+    Entry entry;
+    entry.isValid         = true;
+    entry.lat             = info.lat;
+    entry.lng             = info.lng;
+    entry.platformName    = info.platformName;
+    entry.platformVersion = info.platformVersion;
+    insertEntry(fileInfo, entry);
+}
+
+bool ScanCache::findEntry(const QFileInfo& fileInfo, Entry& entry)
+{
+    QMutexLocker                    locker(&m_mutex);
+    QHash<QString, Entry>::iterator it = m_entries.find(fileInfo.filePath());
+    if (it == m_entries.end() || it.value().size != fileInfo.size() ||
+        it.value().modified != fileInfo.lastModified().toMSecsSinceEpoch())
+    {
+        return false;
+    }
+
+    it.value().isUsed = true;
+    entry             = it.value();
+    return true;
+}
+
+void ScanCache::insertEntry(const QFileInfo& fileInfo, Entry& entry)
+{
+    entry.size     = fileInfo.size();
+    entry.modified = fileInfo.lastModified().toMSecsSinceEpoch();
+    entry.isUsed   = true;
+
+    QMutexLocker locker(&m_mutex);
+    m_entries.insert(fileInfo.filePath(), entry);
+}
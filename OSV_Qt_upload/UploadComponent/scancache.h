@@ -0,0 +1,52 @@
+#ifndef SCANCACHE_H
+#define SCANCACHE_H
+
+#include "metadata.h"
+#include "photo.h"
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+
+/*
+ * Results of previous scans, saved next to save.json.
+ * Entries are keyed by the file path and are only valid while the size and the modification time
+ * of the file are unchanged, so a warm scan only stats the files. Lookups are thread safe.
+ * Entries not looked up or inserted since loading are dropped on save.
+ */
+class ScanCache
+{
+public:
+    explicit ScanCache(const QString& filePath);
+
+    bool load();
+    bool save();
+
+    bool findPhoto(const QFileInfo& fileInfo, PhotoInfo& info, bool& isValid);
+    void insertPhoto(const QFileInfo& fileInfo, const PhotoInfo& info, const bool isValid);
+
+    bool findTrack(const QFileInfo& fileInfo, TrackInfo& info);
+    void insertTrack(const QFileInfo& fileInfo, const TrackInfo& info);
+
+private:
+    struct Entry
+    {
+        qint64     size;
+        qint64     modified;
+        bool       isValid;
+        double     lat;
+        double     lng;
+        QByteArray dateTimeOriginal;
+        QString    platformName;
+        QString    platformVersion;
+        bool       isUsed;
+    };
+
+    bool findEntry(const QFileInfo& fileInfo, Entry& entry);
+    void insertEntry(const QFileInfo& fileInfo, Entry& entry);
+
+    const QString         m_filePath;
+    QHash<QString, Entry> m_entries;
+    QMutex                m_mutex;
+};
+
+#endif  // SCANCACHE_H
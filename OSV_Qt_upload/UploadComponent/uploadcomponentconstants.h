@@ -35,6 +35,66 @@ Constant numbers
 */
 static const int kGigaByte = 1073741824;
 static const int kCountThreads = 6;
+static const int kScanProgressInterval = 200;
+static const int kExifBatchChunk = 64;
+static const int kTrackCompressionLevel = 6;
+
+/*
+Upload concurrency (the number of files in flight starts at kCountThreads). kMaxConcurrency is the
+six connections of each of the kUploadShards managers, an upload beyond that would wait in the queue
+of a manager with its deadline running
+*/
+static const int kMinConcurrency = 1;
+static const int kMaxConcurrency = 24;
+static const int kConcurrencySampleInterval = 2000;
+static const double kConcurrencyLatencyInflation = 2.0;
+static const double kConcurrencyGoodputGain = 0.05;
+static const double kConcurrencyDecreaseFactor = 0.7;
+
+/*
+Network access managers the file uploads are spread on, each opens at most six connections
+*/
+static const int kUploadShards = 4;
+
+/*
+Request watchdog (times in milliseconds), a file upload is aborted and retried if its body is
+not sent any further for kRequestStallTimeout or if it is slower than kRequestMinimumRate (bytes/s)
+*/
+static const int kRequestStallTimeout = 30000;
+static const int kRequestDeadline = 60000;
+static const int kRequestMinimumRate = 16 * 1024;
+
+/*
+Persistence, the progress journal is compacted into save.json after this many records
+*/
+static const int kJournalCompactThreshold = 1000;
+
+/*
+Upload progress, published to QML at most once per kProgressPublishInterval milliseconds
+*/
+static const int kProgressPublishInterval = 100;
+
+/*
+Upload rate and time estimation (milliseconds), the rate is smoothed over kRateWindow and every
+file left adds kFileServerOverhead of server processing to the estimation
+*/
+static const int kRateWindow = 5000;
+static const int kFileServerOverhead = 400;
+
+/*
+Sequences uploaded at the same time, a new one is opened while the previous ones drain
+*/
+static const int kMaxOpenSequences = 3;
+
+/*
+Retry policy (delays in milliseconds)
+*/
+static const int kRetryPhotoBaseDelay = 500;
+static const int kRetryVideoBaseDelay = 2000;
+static const int kRetrySequenceBaseDelay = 1000;
+static const int kRetryMaxDelay = 60000;
+static const int kRetryFileMaxAttempts = 8;
+static const int kRetrySequenceMaxAttempts = 10;
 
 /*
 Status Codes
@@ -57,4 +117,21 @@ enum class FileStatus : int {   AVAILABLE = 0,
                                 BUSY = 1,
                                 DONE = 2};
 
+/*
+Request errors
+*/
+enum class RequestError : int { NONE = 0,
+                                NETWORK = 1,
+                                SERVER = 2,
+                                UNEXPECTED = 3,
+                                UNAUTHORIZED = 4,
+                                REJECTED = 5};
+
+/*
+EXIF extraction status
+*/
+enum class ExifStatus : int {   VALID = 0,
+                                NO_LOCATION = 1,
+                                SKIPPED = 2};
+
 #endif
@@ -1,158 +1,99 @@
 #include "uploadcontroller.h"
+#include "uploadcomponentconstants.h"
+#include <QCoreApplication>
 
 UploadController::UploadController(LoginController* lc, PersistentController* pc, QObject* parent)
     : QObject(parent)
+    , m_isUploadPaused(false)
+    , m_remainingTime(0)
+    , m_uploadedNoFiles(0)
+    , m_uploadedSize(0)
+    , m_percentage(0)
+    , m_uploadSpeed(0)
+    , m_averageUploadSpeed(0)
+    , m_isUploadStarted(false)
+    , m_elapsedTime(0)
+    , m_isError(false)
+    , m_isUploadComplete(false)
+    , m_minConcurrency(kMinConcurrency)
+    , m_maxConcurrency(kMaxConcurrency)
+    , m_currentConcurrency(kCountThreads)
     , m_loginController(lc)
     , m_persistentController(pc)
-    , m_isUploadPaused(false)
     , m_elapsedTimeCounter(new ElapsedTimeCounter())
-    , m_OSVAPI(new OSVAPI())
-    , m_isUploadComplete(false)
-    , m_isError(false)
-{
-    reset();
-    onInformationChanged();
-
-    connect(m_OSVAPI, SIGNAL(errorFound()), this, SLOT(onErrorFound()));
-    connect(m_OSVAPI, SIGNAL(sequenceCreated(int)), this, SLOT(onSequenceCreated(int)));
-    connect(m_OSVAPI, SIGNAL(SequenceFinished(int)), this, SLOT(onSequenceFinished(int)));
-    connect(m_OSVAPI, SIGNAL(photoUploaded(int, int)), this, SLOT(onPhotoUploaded(int, int)));
-    connect(m_OSVAPI, SIGNAL(videoUploaded(int, int)), this, SLOT(onVideoUploaded(int, int)));
-    connect(m_OSVAPI, SIGNAL(uploadProgress(qint64)), this, SLOT(onUploadProgress(qint64)));
-    connect(m_persistentController, SIGNAL(informationChanged()), this,
+    , m_engineThread(new QThread(this))
+    , m_engine(new UploadEngine(pc))
+{
+    m_engine->moveToThread(m_engineThread);
+    connect(m_engineThread, SIGNAL(finished()), m_engine, SLOT(deleteLater()));
+    connect(m_engine, SIGNAL(progressChanged(UploadProgress)), this,
+            SLOT(onProgressChanged(UploadProgress)));
+    connect(m_engine, SIGNAL(uploadStarted()), this, SLOT(onUploadStarted()));
+    connect(m_engine, SIGNAL(uploadComplete()), this, SLOT(onUploadComplete()));
+    connect(m_engine, SIGNAL(errorFound()), this, SLOT(onErrorFound()));
+    connect(m_engine, SIGNAL(concurrencyChanged(int, int, int)), this,
+            SLOT(onConcurrencyChanged(int, int, int)));
+    connect(m_persistentController, SIGNAL(informationChanged()), m_engine,
             SLOT(onInformationChanged()));
     connect(m_elapsedTimeCounter, SIGNAL(elapsedTimeChanged()), this, SLOT(onElapsedTimeChanged()));
+    connect(QCoreApplication::instance(), SIGNAL(aboutToQuit()), this, SLOT(onAboutToQuit()));
+
+    // queued before any command, the engine builds its objects on its own thread
+    QMetaObject::invokeMethod(m_engine, "initialize", Qt::QueuedConnection);
+    m_engineThread->start();
 }
 
 UploadController::~UploadController()
 {
-    disconnect(m_OSVAPI, SIGNAL(sequenceCreated(int)), this, SLOT(onSequenceCreated(int)));
-    disconnect(m_OSVAPI, SIGNAL(sequenceFinished(int)), this, SLOT(onSequenceFinished(int)));
-    disconnect(m_OSVAPI, SIGNAL(photoUploaded(int, int)), this, SLOT(onPhotoUploaded(int, int)));
-    disconnect(m_OSVAPI, SIGNAL(videoUploaded(int, int)), this, SLOT(onVideoUploaded(int, int)));
-    disconnect(m_OSVAPI, SIGNAL(uploadProgress(qint64)), this, SLOT(onUploadProgress(qint64)));
-    disconnect(m_persistentController, SIGNAL(informationChanged()), this,
-               SLOT(onInformationChanged()));
+    onAboutToQuit();
     disconnect(m_elapsedTimeCounter, SIGNAL(elapsedTimeChanged()), this,
                SLOT(onElapsedTimeChanged()));
 }
 
+// the engine is deleted on its thread, once the requests it is running are dropped
+void UploadController::onAboutToQuit()
+{
+    m_engineThread->quit();
+    m_engineThread->wait();
+}
+
 void UploadController::startUpload()
 {
+    // the engine refers to the sequences by index from now on
+    m_persistentController->setIsUploading(true);
     m_elapsedTimeCounter->start();
-    selectNewSequence();
+    QMetaObject::invokeMethod(m_engine, "start", Qt::QueuedConnection,
+                              Q_ARG(QString, m_loginController->getClientToken()));
 }
 
-void UploadController::selectNewSequence()
+void UploadController::onUploadStarted()
 {
-    int sequenceIndex = 0;
-    while (sequenceIndex < m_persistentController->getPersistentSequences().count() &&
-           (m_persistentController->getElement(sequenceIndex)->getSequenceStatus() ==
-            SequenceStatus::SUCCESS))
-    {
-        sequenceIndex++;
-    }
-    if (sequenceIndex < m_persistentController->getPersistentSequences().count())
-    {
-        setIsUploadStarted(true);
-        UploadSequence(m_persistentController->getElement(sequenceIndex), sequenceIndex);
-    }
-    else  // here all the upload is finished
-    {
-        m_elapsedTimeCounter->stop();
-        setIsUploadComplete(true);
-    }
+    setIsUploadStarted(true);
 }
 
-void UploadController::UploadSequence(PersistentSequence* sequence, const int sequenceIndex)
+void UploadController::onUploadComplete()
 {
-    sequence->setToken(m_loginController->getClientToken());
-    const int photoCount(sequence->getPhotos().count());
-    const int videoCount(sequence->getVideos().count());
-
-    switch (sequence->getSequenceStatus())
-    {
-        case SequenceStatus::AVAILABLE:
-            m_OSVAPI->requestNewSequence(sequence, sequenceIndex);
-            break;
-        case SequenceStatus::BUSY:
-            for (int index = 0; index < kCountThreads; index++)
-            {
-                if (photoCount)
-                {
-                    const int multithreadIndex = sequence->getIndexOfNextAvailablePhoto();
-                    if (multithreadIndex != -1)
-                    {
-                        m_OSVAPI->requestNewPhoto(sequence, sequenceIndex, multithreadIndex);
-                    }
-                    else if (multithreadIndex == -1 && sequence->areAllFilesSent())
-                    {
-                        m_OSVAPI->requestSequenceFinished(sequence, sequenceIndex);
-                        break;
-                    }
-                }
-
-                if (videoCount)
-                {
-                    const int multithreadIndex = sequence->getIndexOfNextAvailableVideo();
-                    if (multithreadIndex != -1)
-                    {
-                        m_OSVAPI->requestNewVideo(sequence, sequenceIndex, multithreadIndex);
-                    }
-                    else if (multithreadIndex == -1 && sequence->areAllFilesSent())
-                    {
-                        m_OSVAPI->requestSequenceFinished(sequence, sequenceIndex);
-                        break;
-                    }
-                }
-            }
-            break;
-        case SequenceStatus::FAILED:  // TODO same functionality as in BUSY, maybe eliminate
-                                      // Failed/Busy
-            onInformationChanged();
-            if (sequence->sequenceId() > -1)
-            {
-                if (photoCount)
-                    m_OSVAPI->requestNewPhoto(sequence, sequenceIndex,
-                                              sequence->getIndexOfNextAvailablePhoto());
-                else
-                    m_OSVAPI->requestNewVideo(sequence, sequenceIndex,
-                                              sequence->getIndexOfNextAvailablePhoto());
-            }
-            else
-            {
-                m_OSVAPI->requestNewSequence(sequence, sequenceIndex);
-            }
-            break;
-        case SequenceStatus::FAILED_FINISH:
-            m_OSVAPI->requestSequenceFinished(sequence, sequenceIndex);
-            break;
-        default:
-            selectNewSequence();
-            break;
-    }
+    m_elapsedTimeCounter->stop();
+    setIsUploadComplete(true);
 }
 
-void UploadController::onSequenceCreated(int sequenceIndex)
+void UploadController::onConcurrencyChanged(int minConcurrency, int maxConcurrency,
+                                            int currentConcurrency)
 {
-    PersistentSequence* sequence = m_persistentController->getElement(sequenceIndex);
-    m_persistentController->updatePersistentObject(sequence);
-
-    if (sequence->getPhotos().size())
+    if (m_minConcurrency != minConcurrency)
+    {
+        m_minConcurrency = minConcurrency;
+        emit minConcurrencyChanged();
+    }
+    if (m_maxConcurrency != maxConcurrency)
     {
-        qDebug() << "New photo sequence!";
-        for (int index = 0; index < kCountThreads && index < sequence->getPhotos().size(); index++)
-        {
-            m_OSVAPI->requestNewPhoto(sequence, sequenceIndex, index);
-        }
+        m_maxConcurrency = maxConcurrency;
+        emit maxConcurrencyChanged();
     }
-    else if (sequence->getVideos().size())
+    if (m_currentConcurrency != currentConcurrency)
     {
-        qDebug() << "New video sequence!";
-        for (int index = 0; index < kCountThreads && index < sequence->getVideos().size(); index++)
-        {
-            m_OSVAPI->requestNewVideo(sequence, sequenceIndex, index);
-        }
+        m_currentConcurrency = currentConcurrency;
+        emit currentConcurrencyChanged();
     }
 }
 
@@ -172,84 +113,25 @@ double UploadController::calculateProgressPercentage()
     return 0.9 * uploadedSizePerc + 0.1 * serverReplyPerc;
 }
 
-void UploadController::onUploadProgress(qint64 bytesDiff)
+void UploadController::onProgressChanged(const UploadProgress& progress)
 {
-    const int timeDiff = m_elapsedTimeCounter->getElapsedTime();
-    int       remainingTimeSec;
-    qint64    speed;
-    setUploadedSize(m_uploadedSize + bytesDiff);
-    if (timeDiff > 0)
-    {
-        speed              = m_uploadedSize / timeDiff;  // Download Speed in B/s
-        qint64 remainingUp = m_persistentController->get_totalSize() - m_uploadedSize;
-        if (speed)
-        {
-            remainingTimeSec = remainingUp / speed;
-            setUploadSpeed(speed);
-            setRemainingTime(remainingTimeSec);
-        }
-    }
+    setUploadedNoFiles(progress.uploadedFiles);
+    setUploadedSize(qMin(progress.uploadedSize, (qint64)m_persistentController->get_totalSize()));
+    setUploadSpeed(progress.uploadRate);
+    setAverageUploadSpeed(progress.averageRate);
 
-    if (m_uploadedSize > m_persistentController->get_totalSize())
+    const int remainingTime = RateEstimator::remainingTime(
+        m_persistentController->get_totalSize() - m_uploadedSize,
+        m_persistentController->get_totalFiles() - m_uploadedNoFiles, progress.uploadRate,
+        m_currentConcurrency, kFileServerOverhead);
+    if (remainingTime >= 0)
     {
-        setUploadedSize(m_persistentController->get_totalSize());
+        setRemainingTime(remainingTime);
     }
 
     setPercentage(calculateProgressPercentage());
 }
 
-void UploadController::onPhotoUploaded(int sequenceIndex, int photoIndex)
-{
-    PersistentSequence* sequence = m_persistentController->getElement(sequenceIndex);
-
-    if (!sequence->isFileSent(photoIndex))  // make sure is not duplicated
-    {
-        sequence->setFileSentOnIndex(photoIndex);
-        setUploadedNoFiles(m_uploadedNoFiles + 1);
-        m_persistentController->updatePersistentObject(sequence);
-    }
-
-    const int nextIndex = sequence->getIndexOfNextAvailablePhoto();
-    if (nextIndex != -1)
-    {
-        m_OSVAPI->requestNewPhoto(sequence, sequenceIndex, nextIndex);
-    }
-    else if (sequence->areAllFilesSent())
-    {
-        m_OSVAPI->requestSequenceFinished(sequence, sequenceIndex);
-    }
-}
-
-void UploadController::onVideoUploaded(int sequenceIndex, int videoIndex)
-{
-    PersistentSequence* sequence = m_persistentController->getElement(sequenceIndex);
-
-    if (!sequence->isFileSent(videoIndex))  // make sure is not duplicated
-    {
-        sequence->setFileSentOnIndex(videoIndex);
-        setUploadedNoFiles(m_uploadedNoFiles + 1);
-        m_persistentController->updatePersistentObject(sequence);
-    }
-
-    const int nextIndex = sequence->getIndexOfNextAvailableVideo();
-    if (nextIndex != -1)
-    {
-        m_OSVAPI->requestNewVideo(sequence, sequenceIndex, nextIndex);
-    }
-    else if (sequence->areAllFilesSent())
-    {
-        m_OSVAPI->requestSequenceFinished(sequence, sequenceIndex);
-    }
-}
-
-void UploadController::onSequenceFinished(int sequenceIndex)
-{
-    qDebug() << "Sequence Finished!";
-    m_persistentController->updatePersistentObject(
-        m_persistentController->getElement(sequenceIndex));
-    selectNewSequence();
-}
-
 /*
  *  Function pauses/resumes upload when pressed
  *  If paused, the button's property changes to resume and vice-versa
@@ -259,7 +141,7 @@ void UploadController::pauseUpload()
     qDebug() << "pause upload";
     setIsUploadPaused(true);
     blockSignals(true);
-    m_OSVAPI->pauseUpload();
+    QMetaObject::invokeMethod(m_engine, "pause", Qt::QueuedConnection);
     m_elapsedTimeCounter->pause();
 }
 
@@ -267,88 +149,18 @@ void UploadController::resumeUpload()
 {
     qDebug() << "resume upload ";
     blockSignals(false);
+    // values set while the signals were blocked would not be notified by the setters
+    emit uploadedNoFilesChanged();
+    emit uploadedSizeChanged();
+    emit uploadSpeedChanged();
+    emit averageUploadSpeedChanged();
+    emit remainingTimeChanged();
+    emit percentageChanged();
+    emit elapsedTimeChanged();
     setIsUploadPaused(false);
     m_elapsedTimeCounter->resume();
-    m_OSVAPI->resumeUpload();
-    m_persistentController->resetStatusForUnsentSequenceFiles();
-    onInformationChanged();
-    selectNewSequence();
-}
-
-void UploadController::onInformationChanged()
-{
-    int    uploadedFiles = 0;
-    qint64 uploadedSize  = 0;
-    foreach (PersistentSequence* s, m_persistentController->getPersistentSequences())
-    {
-        if (s->getSequenceStatus() != SequenceStatus::SUCCESS)
-        {
-            if (!s->getMetadata()->getPath().isEmpty() &&
-                s->getSequenceStatus() != SequenceStatus::AVAILABLE)
-            {
-                uploadedSize += s->getMetadata()->getSize();
-            }
-
-            m_persistentController->updatePersistentObject(s);
-
-            if (s->type() == PersistentSequence::SequenceType::PHOTO)
-            {
-                const QList<Photo*> photos(s->getPhotos());
-                int                 photoIndex = 0;
-                while (photoIndex < photos.count())
-                {
-                    if (s->isFileSent(photoIndex))
-                    {
-                        Photo* currentPhoto = photos[photoIndex];
-                        currentPhoto->setStatus(FileStatus::DONE);
-                        ++uploadedFiles;
-                        uploadedSize += currentPhoto->getSize();
-                    }
-                    ++photoIndex;
-                }
-            }
-            else if (s->type() == PersistentSequence::SequenceType::VIDEO)
-            {
-                const QList<Video*> videos(s->getVideos());
-                int                 videoIndex = 0;
-                while (videoIndex < videos.count())
-                {
-                    if (s->isFileSent(videoIndex))
-                    {
-                        Video* currentVideo = videos[videoIndex];
-                        currentVideo->setStatus(FileStatus::DONE);
-                        ++uploadedFiles;
-                        uploadedSize += currentVideo->getSize();
-                    }
-                    ++videoIndex;
-                }
-            }
-        }
-        else if (s->getSequenceStatus() == SequenceStatus::SUCCESS)
-        {
-            if (s->type() == PersistentSequence::SequenceType::PHOTO)
-            {
-                uploadedFiles += s->getPhotos().size();
-            }
-            else if (s->type() == PersistentSequence::SequenceType::VIDEO)
-            {
-                uploadedFiles += s->getVideos().size();
-            }
-            uploadedSize += s->size();
-        }
-    }
-
-    setUploadedNoFiles(uploadedFiles);
-    setUploadedSize(uploadedSize);
-
-    if (m_persistentController->get_totalSize())
-    {
-        setPercentage(calculateProgressPercentage());
-    }
-    else
-    {
-        setPercentage(0);
-    }
+    QMetaObject::invokeMethod(m_engine, "resume", Qt::QueuedConnection,
+                              Q_ARG(QString, m_loginController->getClientToken()));
 }
 
 void UploadController::onErrorFound()  // send also a message
@@ -377,6 +189,7 @@ void UploadController::resetUploadValues()
 void UploadController::reset()
 {
     setIsUploadStarted(false);
+    m_persistentController->setIsUploading(false);
     setElapsedTime(0);
     m_elapsedTimeCounter->reset();
 
@@ -384,8 +197,10 @@ void UploadController::reset()
     setUploadedNoFiles(0);
     setUploadedSize(0);
     setUploadSpeed(0);
+    setAverageUploadSpeed(0);
     setPercentage(0);
     setRemainingTime(0);
+    QMetaObject::invokeMethod(m_engine, "reset", Qt::QueuedConnection);
 }
 
 // Getters
@@ -419,6 +234,11 @@ long long UploadController::uploadSpeed() const
     return m_uploadSpeed;
 }
 
+long long UploadController::averageUploadSpeed() const
+{
+    return m_averageUploadSpeed;
+}
+
 bool UploadController::isUploadStarted() const
 {
     return m_isUploadStarted;
@@ -439,63 +259,140 @@ bool UploadController::isUploadComplete() const
     return m_isUploadComplete;
 }
 
-// Setters
+int UploadController::minConcurrency() const
+{
+    return m_minConcurrency;
+}
+
+int UploadController::maxConcurrency() const
+{
+    return m_maxConcurrency;
+}
+
+int UploadController::currentConcurrency() const
+{
+    return m_currentConcurrency;
+}
+
+// Setters, the properties are notified only when their value changes
 void UploadController::setIsUploadPaused(const bool isUploadPaused)
 {
+    if (m_isUploadPaused == isUploadPaused)
+    {
+        return;
+    }
     m_isUploadPaused = isUploadPaused;
     emit isUploadPausedChanged();
 }
 
 void UploadController::setRemainingTime(const int remainingTime)
 {
+    if (m_remainingTime == remainingTime)
+    {
+        return;
+    }
     m_remainingTime = remainingTime;
     emit remainingTimeChanged();
 }
 
 void UploadController::setUploadedNoFiles(const int uploadedNoFiles)
 {
+    if (m_uploadedNoFiles == uploadedNoFiles)
+    {
+        return;
+    }
     m_uploadedNoFiles = uploadedNoFiles;
     emit uploadedNoFilesChanged();
 }
 
 void UploadController::setUploadedSize(const long long& uploadedSize)
 {
+    if (m_uploadedSize == uploadedSize)
+    {
+        return;
+    }
     m_uploadedSize = uploadedSize;
     emit uploadedSizeChanged();
 }
 
 void UploadController::setPercentage(const int percentage)
 {
+    if (m_percentage == percentage)
+    {
+        return;
+    }
     m_percentage = percentage;
     emit percentageChanged();
 }
 
 void UploadController::setUploadSpeed(const long long& uploadSpeed)
 {
+    if (m_uploadSpeed == uploadSpeed)
+    {
+        return;
+    }
     m_uploadSpeed = uploadSpeed;
     emit uploadSpeedChanged();
 }
 
+void UploadController::setAverageUploadSpeed(const long long& averageUploadSpeed)
+{
+    if (m_averageUploadSpeed == averageUploadSpeed)
+    {
+        return;
+    }
+    m_averageUploadSpeed = averageUploadSpeed;
+    emit averageUploadSpeedChanged();
+}
+
 void UploadController::setIsUploadStarted(const bool isUploadStarted)
 {
+    if (m_isUploadStarted == isUploadStarted)
+    {
+        return;
+    }
     m_isUploadStarted = isUploadStarted;
     emit isUploadStartedChanged();
 }
 
 void UploadController::setElapsedTime(const long long& elapsedTime)
 {
+    if (m_elapsedTime == elapsedTime)
+    {
+        return;
+    }
     m_elapsedTime = elapsedTime;
     emit elapsedTimeChanged();
 }
 
 void UploadController::setIsError(const bool isError)
 {
+    if (m_isError == isError)
+    {
+        return;
+    }
     m_isError = isError;
     emit isErrorChanged();
 }
 
 void UploadController::setIsUploadComplete(const bool isUploadComplete)
 {
+    if (m_isUploadComplete == isUploadComplete)
+    {
+        return;
+    }
     m_isUploadComplete = isUploadComplete;
     emit isUploadCompleteChanged();
 }
+
+void UploadController::setMinConcurrency(const int minConcurrency)
+{
+    QMetaObject::invokeMethod(m_engine, "setMinConcurrency", Qt::QueuedConnection,
+                              Q_ARG(int, minConcurrency));
+}
+
+void UploadController::setMaxConcurrency(const int maxConcurrency)
+{
+    QMetaObject::invokeMethod(m_engine, "setMaxConcurrency", Qt::QueuedConnection,
+                              Q_ARG(int, maxConcurrency));
+}
@@ -1,12 +1,19 @@
 #ifndef UPLOADCONTROLLER_H
 #define UPLOADCONTROLLER_H
 
-#include "OSVAPI.h"
 #include "elapsedtimecounter.h"
 #include "logincontroller.h"
 #include "persistentcontroller.h"
 #include "qqmlhelpers.h"
+#include "uploadengine.h"
+#include <QThread>
 
+/*
+ * Face of the upload towards QML, lives on the GUI thread.
+ * The upload itself is done by an UploadEngine on a thread of its own: the controller hands it the
+ * commands of the user through queued calls and only copies the progress it reports into the
+ * properties, so the upload does not depend on how busy the GUI thread is.
+ */
 class UploadController : public QObject
 {
     Q_OBJECT
@@ -16,10 +23,14 @@ class UploadController : public QObject
     Q_PROPERTY(long long uploadedSize READ uploadedSize NOTIFY uploadedSizeChanged)
     Q_PROPERTY(int percentage READ percentage NOTIFY percentageChanged)
     Q_PROPERTY(long long uploadSpeed READ uploadSpeed NOTIFY uploadSpeedChanged)
+    Q_PROPERTY(long long averageUploadSpeed READ averageUploadSpeed NOTIFY averageUploadSpeedChanged)
     Q_PROPERTY(bool isUploadStarted READ isUploadStarted NOTIFY isUploadStartedChanged)
     Q_PROPERTY(long long elapsedTime READ elapsedTime NOTIFY elapsedTimeChanged)
     Q_PROPERTY(bool isError READ isError NOTIFY isErrorChanged)
     Q_PROPERTY(bool isUploadComplete READ isUploadComplete NOTIFY isUploadCompleteChanged)
+    Q_PROPERTY(int minConcurrency READ minConcurrency WRITE setMinConcurrency NOTIFY minConcurrencyChanged)
+    Q_PROPERTY(int maxConcurrency READ maxConcurrency WRITE setMaxConcurrency NOTIFY maxConcurrencyChanged)
+    Q_PROPERTY(int currentConcurrency READ currentConcurrency NOTIFY currentConcurrencyChanged)
 
 public:
     explicit UploadController(LoginController* lc, PersistentController* pc, QObject* parent = 0);
@@ -33,10 +44,14 @@ public:
     long long uploadedSize() const;
     int       percentage() const;
     long long uploadSpeed() const;
+    long long averageUploadSpeed() const;
     bool      isUploadStarted() const;
     long long elapsedTime() const;
     bool      isError() const;
     bool      isUploadComplete() const;
+    int       minConcurrency() const;
+    int       maxConcurrency() const;
+    int       currentConcurrency() const;
 
     // Setters
     void setIsUploadPaused(const bool isUploadPaused);
@@ -45,10 +60,13 @@ public:
     void setUploadedSize(const long long& uploadedSize);
     void setPercentage(const int percentage);
     void setUploadSpeed(const long long& uploadSpeed);
+    void setAverageUploadSpeed(const long long& averageUploadSpeed);
     void setIsUploadStarted(const bool isUploadStarted);
     void setElapsedTime(const long long& elapsedTime);
     void setIsError(const bool isError);
     void setIsUploadComplete(const bool isUploadComplete);
+    void setMinConcurrency(const int minConcurrency);
+    void setMaxConcurrency(const int maxConcurrency);
 
 signals:
     void isUploadPausedChanged();
@@ -57,30 +75,31 @@ signals:
     void uploadedSizeChanged();
     void percentageChanged();
     void uploadSpeedChanged();
+    void averageUploadSpeedChanged();
     void isUploadStartedChanged();
     void elapsedTimeChanged();
     void isErrorChanged();
     void isUploadCompleteChanged();
+    void minConcurrencyChanged();
+    void maxConcurrencyChanged();
+    void currentConcurrencyChanged();
 
 public slots:
-    void UploadSequence(PersistentSequence* sequence, const int sequenceIndex);
-    void onUploadProgress(qint64 bytesDiff);
+    void onProgressChanged(const UploadProgress& progress);
     void pauseUpload();
     void resumeUpload();
-    void onSequenceCreated(int sequenceIndex);
-    void onPhotoUploaded(int sequenceIndex, int photoIndex);
-    void onVideoUploaded(int sequenceIndex, int videoIndex);
-    void onSequenceFinished(int sequenceIndex);
-    void onInformationChanged();
+    void onUploadStarted();
+    void onUploadComplete();
     void onElapsedTimeChanged();
     void onErrorFound();
+    void onConcurrencyChanged(int minConcurrency, int maxConcurrency, int currentConcurrency);
+    void onAboutToQuit();
 
     Q_INVOKABLE void startUpload();
     Q_INVOKABLE void resetUploadValues();
     Q_INVOKABLE void errorAknowledged();
 
 private:
-    void   selectNewSequence();
     double calculateProgressPercentage();
 
 private:
@@ -90,15 +109,21 @@ private:
     long long m_uploadedSize;
     int       m_percentage;
     long long m_uploadSpeed;
+    long long m_averageUploadSpeed;
     bool      m_isUploadStarted;
     long long m_elapsedTime;
     bool      m_isError;
     bool      m_isUploadComplete;
 
-    OSVAPI*               m_OSVAPI;
+    int       m_minConcurrency;
+    int       m_maxConcurrency;
+    int       m_currentConcurrency;
+
     LoginController*      m_loginController;
     PersistentController* m_persistentController;
     ElapsedTimeCounter*   m_elapsedTimeCounter;
+    QThread*              m_engineThread;
+    UploadEngine*         m_engine;
 };
 
 #endif  // UPLOADCONTROLLER_H
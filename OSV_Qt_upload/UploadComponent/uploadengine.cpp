@@ -0,0 +1,494 @@
+#include "uploadengine.h"
+#include "uploadcomponentconstants.h"
+#include <QMutexLocker>
+
+UploadEngine::UploadEngine(PersistentController* pc)
+    : QObject()
+    , m_persistentController(pc)
+    , m_OSVAPI(nullptr)
+    , m_concurrencyController(nullptr)
+    , m_isPaused(false)
+    , m_isError(false)
+    , m_isStarted(false)
+    , m_isComplete(false)
+    , m_inFlightFiles(0)
+    , m_dispatchCursor(0)
+    , m_rateEstimator(kRateWindow)
+    , m_isProgressPending(false)
+    , m_progressTimer(nullptr)
+{
+    qRegisterMetaType<UploadProgress>("UploadProgress");
+    m_progress.uploadedSize  = 0;
+    m_progress.uploadedFiles = 0;
+    m_progress.uploadRate    = 0;
+    m_progress.averageRate   = 0;
+}
+
+// called on the thread of the engine, so the timers and the network managers belong to it
+void UploadEngine::initialize()
+{
+    m_OSVAPI                = new OSVAPI(m_persistentController->mutex(), this);
+    m_concurrencyController = new ConcurrencyController(this);
+    m_progressTimer         = new QTimer(this);
+    m_progressTimer->setSingleShot(true);
+    m_progressTimer->setInterval(kProgressPublishInterval);
+    connect(m_progressTimer, SIGNAL(timeout()), this, SLOT(publishProgress()));
+
+    connect(m_OSVAPI, SIGNAL(errorFound()), this, SLOT(onErrorFound()));
+    connect(m_OSVAPI, SIGNAL(sequenceCreated(int)), this, SLOT(onSequenceCreated(int)));
+    connect(m_OSVAPI, SIGNAL(SequenceFinished(int)), this, SLOT(onSequenceFinished(int)));
+    connect(m_OSVAPI, SIGNAL(photoUploaded(int, int)), this, SLOT(onPhotoUploaded(int, int)));
+    connect(m_OSVAPI, SIGNAL(videoUploaded(int, int)), this, SLOT(onVideoUploaded(int, int)));
+    connect(m_OSVAPI, SIGNAL(uploadProgress(qint64)), this, SLOT(onUploadProgress(qint64)));
+
+    // concurrency is adapted from the goodput and latency of the file requests
+    connect(m_OSVAPI, SIGNAL(uploadProgress(qint64)), m_concurrencyController,
+            SLOT(onBytesSent(qint64)));
+    connect(m_OSVAPI, SIGNAL(fileRequestFinished(qint64, qint64)), m_concurrencyController,
+            SLOT(onRequestFinished(qint64, qint64)));
+    connect(m_OSVAPI, SIGNAL(fileRequestFailed()), m_concurrencyController,
+            SLOT(onRequestFailed()));
+    connect(m_concurrencyController, SIGNAL(minConcurrencyChanged()), this,
+            SLOT(onConcurrencyChanged()));
+    connect(m_concurrencyController, SIGNAL(maxConcurrencyChanged()), this,
+            SLOT(onConcurrencyChanged()));
+    connect(m_concurrencyController, SIGNAL(currentConcurrencyChanged()), this,
+            SLOT(onConcurrencyChanged()));
+
+    onConcurrencyChanged();
+    onInformationChanged();
+}
+
+void UploadEngine::start(const QString& token)
+{
+    m_token      = token;
+    m_isComplete = false;
+    clearOpenSequences();
+    m_rateEstimator.start();
+    m_concurrencyController->start();
+    scheduleUploads();
+}
+
+/*
+ * Keeps the upload slots busy across sequences: files of the open sequences are requested first,
+ * and while slots stay free (the open sequences drain or wait for the server) the next sequence
+ * is created, up to kMaxOpenSequences at a time.
+ * The sequences are changed under the lock of the persistent controller, the GUI thread saves and
+ * counts them meanwhile.
+ */
+void UploadEngine::scheduleUploads()
+{
+    if (m_isPaused || m_isError)
+    {
+        return;
+    }
+
+    QMutexLocker locker(m_persistentController->mutex());
+    dispatchFiles();
+    while (!m_isError && m_inFlightFiles < m_concurrencyController->currentConcurrency() &&
+           m_creatingSequences.isEmpty() && m_openSequences.count() < kMaxOpenSequences)
+    {
+        const int           sequenceIndex = nextSequenceToOpen();
+        PersistentSequence* sequence      = m_persistentController->getElement(sequenceIndex);
+        if (!sequence)
+        {
+            break;
+        }
+        if (!m_isStarted)
+        {
+            m_isStarted = true;
+            emit uploadStarted();
+        }
+        uploadSequence(sequence, sequenceIndex);
+        dispatchFiles();
+    }
+
+    if (m_openSequences.isEmpty() && nextSequenceToOpen() == -1 &&
+        !m_isComplete)  // here all the upload is finished
+    {
+        m_isComplete = true;
+        m_concurrencyController->stop();
+        m_rateEstimator.pause();
+        publishProgress();
+        emit uploadComplete();
+    }
+}
+
+int UploadEngine::nextSequenceToOpen() const
+{
+    const QList<PersistentSequence*> sequences(m_persistentController->getPersistentSequences());
+    for (int sequenceIndex = 0; sequenceIndex < sequences.count(); ++sequenceIndex)
+    {
+        // sequences without files are the ones whose folder was not scanned again
+        if (sequences.at(sequenceIndex)->getSequenceStatus() != SequenceStatus::SUCCESS &&
+            sequences.at(sequenceIndex)->filesNo() > 0 && !m_openSequences.contains(sequenceIndex))
+        {
+            return sequenceIndex;
+        }
+    }
+    return -1;
+}
+
+void UploadEngine::uploadSequence(PersistentSequence* sequence, const int sequenceIndex)
+{
+    sequence->setToken(m_token);
+    m_openSequences.append(sequenceIndex);
+
+    // sequences with a server id get their files from dispatchFiles()
+    switch (sequence->getSequenceStatus())
+    {
+        case SequenceStatus::AVAILABLE:
+            requestNewSequence(sequence, sequenceIndex);
+            break;
+        case SequenceStatus::BUSY:
+            break;
+        case SequenceStatus::FAILED:  // TODO same functionality as in BUSY, maybe eliminate
+                                      // Failed/Busy
+            onInformationChanged();
+            if (sequence->sequenceId() < 0)
+            {
+                requestNewSequence(sequence, sequenceIndex);
+            }
+            break;
+        case SequenceStatus::FAILED_FINISH:
+            m_finishingSequences.insert(sequenceIndex);
+            m_OSVAPI->requestSequenceFinished(sequence, sequenceIndex);
+            break;
+        default:
+            m_openSequences.removeOne(sequenceIndex);
+            break;
+    }
+}
+
+// the request of a new sequence carries the track, a plain one is compressed first
+void UploadEngine::requestNewSequence(PersistentSequence* sequence, const int sequenceIndex)
+{
+    if (sequence->getMetadata() && !sequence->getMetadata()->compressTrack())
+    {
+        m_openSequences.removeOne(sequenceIndex);
+        onErrorFound();
+        return;
+    }
+
+    m_creatingSequences.insert(sequenceIndex);
+    m_OSVAPI->requestNewSequence(sequence, sequenceIndex);
+}
+
+/*
+ * Hands the free upload slots to the open sequences in round robin, so the files of a sequence
+ * that is about to finish do not hold back the next one.
+ */
+void UploadEngine::dispatchFiles()
+{
+    int idleSequences = 0;
+    while (m_inFlightFiles < m_concurrencyController->currentConcurrency() &&
+           idleSequences < m_openSequences.count())
+    {
+        m_dispatchCursor = (m_dispatchCursor + 1) % m_openSequences.count();
+        if (requestNextFile(m_openSequences.at(m_dispatchCursor)))
+        {
+            idleSequences = 0;
+        }
+        else
+        {
+            ++idleSequences;
+        }
+    }
+}
+
+// returns true if a file request of the sequence was started
+bool UploadEngine::requestNextFile(const int sequenceIndex)
+{
+    if (m_creatingSequences.contains(sequenceIndex) || m_finishingSequences.contains(sequenceIndex))
+    {
+        return false;
+    }
+
+    PersistentSequence* sequence = m_persistentController->getElement(sequenceIndex);
+    if (!sequence)
+    {
+        return false;
+    }
+
+    const bool isPhotoSequence = sequence->getPhotos().size() > 0;
+    const int nextIndex = isPhotoSequence ? sequence->getIndexOfNextAvailablePhoto()
+                                          : sequence->getIndexOfNextAvailableVideo();
+    if (nextIndex == -1)
+    {
+        finishSequenceIfSent(sequenceIndex);
+        return false;
+    }
+
+    const bool requested = isPhotoSequence
+                               ? m_OSVAPI->requestNewPhoto(sequence, sequenceIndex, nextIndex)
+                               : m_OSVAPI->requestNewVideo(sequence, sequenceIndex, nextIndex);
+    if (requested)
+    {
+        ++m_inFlightFiles;
+    }
+    else
+    {
+        sequence->releaseFile(nextIndex);
+    }
+    return requested;
+}
+
+void UploadEngine::finishSequenceIfSent(const int sequenceIndex)
+{
+    PersistentSequence* sequence = m_persistentController->getElement(sequenceIndex);
+    if (!sequence || m_finishingSequences.contains(sequenceIndex) || !sequence->areAllFilesSent())
+    {
+        return;
+    }
+
+    m_finishingSequences.insert(sequenceIndex);
+    m_OSVAPI->requestSequenceFinished(sequence, sequenceIndex);
+}
+
+void UploadEngine::clearOpenSequences()
+{
+    m_inFlightFiles = 0;
+    m_openSequences.clear();
+    m_creatingSequences.clear();
+    m_finishingSequences.clear();
+    m_dispatchCursor = 0;
+}
+
+void UploadEngine::onSequenceCreated(int sequenceIndex)
+{
+    QMutexLocker        locker(m_persistentController->mutex());
+    PersistentSequence* sequence = m_persistentController->getElement(sequenceIndex);
+    m_creatingSequences.remove(sequenceIndex);
+    if (sequence)
+    {
+        m_persistentController->updatePersistentObject(sequence);
+        qDebug() << (sequence->getPhotos().size() ? "New photo sequence!" : "New video sequence!");
+    }
+    scheduleUploads();
+}
+
+void UploadEngine::onConcurrencyChanged()
+{
+    emit concurrencyChanged(m_concurrencyController->minConcurrency(),
+                            m_concurrencyController->maxConcurrency(),
+                            m_concurrencyController->currentConcurrency());
+
+    // a larger window is used right away, a smaller one by not refilling the freed slots
+    if (m_isStarted && !m_isComplete)
+    {
+        scheduleUploads();
+    }
+}
+
+void UploadEngine::onUploadProgress(qint64 bytesDiff)
+{
+    m_rateEstimator.addBytes(bytesDiff);
+    setProgress(m_progress.uploadedSize + bytesDiff, m_progress.uploadedFiles);
+}
+
+void UploadEngine::onPhotoUploaded(int sequenceIndex, int photoIndex)
+{
+    onFileUploaded(m_persistentController->getElement(sequenceIndex), sequenceIndex, photoIndex);
+}
+
+void UploadEngine::onVideoUploaded(int sequenceIndex, int videoIndex)
+{
+    onFileUploaded(m_persistentController->getElement(sequenceIndex), sequenceIndex, videoIndex);
+}
+
+void UploadEngine::onFileUploaded(PersistentSequence* sequence, const int sequenceIndex,
+                                  const int fileIndex)
+{
+    QMutexLocker locker(m_persistentController->mutex());
+    if (sequence && !sequence->isFileSent(fileIndex))  // make sure is not duplicated
+    {
+        sequence->setFileSentOnIndex(fileIndex);
+        setProgress(m_progress.uploadedSize, m_progress.uploadedFiles + 1);
+        m_persistentController->markFileSent(sequence, fileIndex);
+    }
+
+    if (m_inFlightFiles > 0)
+    {
+        --m_inFlightFiles;
+    }
+    finishSequenceIfSent(sequenceIndex);
+    scheduleUploads();
+}
+
+void UploadEngine::onSequenceFinished(int sequenceIndex)
+{
+    qDebug() << "Sequence Finished!";
+    QMutexLocker locker(m_persistentController->mutex());
+    m_persistentController->updatePersistentObject(
+        m_persistentController->getElement(sequenceIndex));
+    m_finishingSequences.remove(sequenceIndex);
+    m_openSequences.removeOne(sequenceIndex);
+    scheduleUploads();
+}
+
+void UploadEngine::pause()
+{
+    m_isPaused = true;
+    m_OSVAPI->pauseUpload();
+    m_concurrencyController->stop();
+    m_rateEstimator.pause();
+}
+
+void UploadEngine::resume(const QString& token)
+{
+    m_token    = token;
+    m_isPaused = false;
+    m_OSVAPI->resumeUpload();
+    m_persistentController->resetStatusForUnsentSequenceFiles();
+    // requests interrupted by the pause are started again from scratch
+    clearOpenSequences();
+    m_rateEstimator.resume();
+    m_concurrencyController->start();
+    onInformationChanged();
+    scheduleUploads();
+}
+
+void UploadEngine::reset()
+{
+    m_isError    = false;
+    m_isStarted  = false;
+    m_isComplete = false;
+    m_concurrencyController->reset();
+    m_rateEstimator.reset();
+    clearOpenSequences();
+    m_progress.uploadRate  = 0;
+    m_progress.averageRate = 0;
+    setProgress(0, 0);
+}
+
+void UploadEngine::onInformationChanged()
+{
+    QMutexLocker locker(m_persistentController->mutex());
+    int    uploadedFiles = 0;
+    qint64 uploadedSize  = 0;
+    foreach (PersistentSequence* s, m_persistentController->getPersistentSequences())
+    {
+        if (s->getSequenceStatus() != SequenceStatus::SUCCESS)
+        {
+            if (s->getMetadata() && !s->getMetadata()->getPath().isEmpty() &&
+                s->getSequenceStatus() != SequenceStatus::AVAILABLE)
+            {
+                uploadedSize += s->getMetadata()->getSize();
+            }
+
+            m_persistentController->updatePersistentObject(s);
+
+            if (s->type() == PersistentSequence::SequenceType::PHOTO)
+            {
+                const QList<Photo*> photos(s->getPhotos());
+                int                 photoIndex = 0;
+                while (photoIndex < photos.count())
+                {
+                    if (s->isFileSent(photoIndex))
+                    {
+                        Photo* currentPhoto = photos[photoIndex];
+                        currentPhoto->setStatus(FileStatus::DONE);
+                        ++uploadedFiles;
+                        uploadedSize += currentPhoto->getSize();
+                    }
+                    ++photoIndex;
+                }
+            }
+            else if (s->type() == PersistentSequence::SequenceType::VIDEO)
+            {
+                const QList<Video*> videos(s->getVideos());
+                int                 videoIndex = 0;
+                while (videoIndex < videos.count())
+                {
+                    if (s->isFileSent(videoIndex))
+                    {
+                        Video* currentVideo = videos[videoIndex];
+                        currentVideo->setStatus(FileStatus::DONE);
+                        ++uploadedFiles;
+                        uploadedSize += currentVideo->getSize();
+                    }
+                    ++videoIndex;
+                }
+            }
+        }
+        else if (s->getSequenceStatus() == SequenceStatus::SUCCESS)
+        {
+            if (s->type() == PersistentSequence::SequenceType::PHOTO)
+            {
+                uploadedFiles += s->getPhotos().size();
+            }
+            else if (s->type() == PersistentSequence::SequenceType::VIDEO)
+            {
+                uploadedFiles += s->getVideos().size();
+            }
+            uploadedSize += s->size();
+        }
+    }
+
+    setProgress(uploadedSize, uploadedFiles);
+}
+
+void UploadEngine::onErrorFound()  // send also a message
+{
+    m_isError = true;
+    m_concurrencyController->stop();
+    m_rateEstimator.pause();
+    publishProgress();
+    emit errorFound();
+}
+
+void UploadEngine::setMinConcurrency(const int minConcurrency)
+{
+    m_concurrencyController->setMinConcurrency(minConcurrency);
+}
+
+void UploadEngine::setMaxConcurrency(const int maxConcurrency)
+{
+    m_concurrencyController->setMaxConcurrency(maxConcurrency);
+}
+
+// only the counters are updated here, the first change after a snapshot arms the next one
+void UploadEngine::setProgress(const qint64 uploadedSize, const int uploadedFiles)
+{
+    if (m_progress.uploadedSize == uploadedSize && m_progress.uploadedFiles == uploadedFiles)
+    {
+        return;
+    }
+
+    m_progress.uploadedSize  = uploadedSize;
+    m_progress.uploadedFiles = uploadedFiles;
+    m_isProgressPending      = true;
+    if (!m_progressTimer->isActive())
+    {
+        m_progressTimer->start();
+    }
+}
+
+bool UploadEngine::isRunning() const
+{
+    return m_isStarted && !m_isComplete && !m_isPaused && !m_isError;
+}
+
+// while the upload runs the rates are sampled at every snapshot, a stalled upload shows its rate drop
+void UploadEngine::publishProgress()
+{
+    m_progressTimer->stop();
+    if (isRunning())
+    {
+        m_rateEstimator.update();
+        if (m_progress.uploadRate != m_rateEstimator.smoothedRate() ||
+            m_progress.averageRate != m_rateEstimator.averageRate())
+        {
+            m_progress.uploadRate  = m_rateEstimator.smoothedRate();
+            m_progress.averageRate = m_rateEstimator.averageRate();
+            m_isProgressPending    = true;
+        }
+        m_progressTimer->start();
+    }
+
+    if (m_isProgressPending)
+    {
+        m_isProgressPending = false;
+        emit progressChanged(m_progress);
+    }
+}
@@ -0,0 +1,105 @@
+#ifndef UPLOADENGINE_H
+#define UPLOADENGINE_H
+
+#include "OSVAPI.h"
+#include "concurrencycontroller.h"
+#include "persistentcontroller.h"
+#include "rateestimator.h"
+#include <QMetaType>
+#include <QSet>
+#include <QTimer>
+
+/*
+ * Counters of the upload as the engine sees them, handed to the GUI thread by value.
+ * A snapshot is taken at most every kProgressPublishInterval, whatever the size of the chunks the
+ * network layer reports.
+ */
+struct UploadProgress
+{
+    qint64 uploadedSize;
+    int    uploadedFiles;
+    double uploadRate;   // B/s, smoothed
+    double averageRate;  // B/s, since the upload started
+};
+Q_DECLARE_METATYPE(UploadProgress)
+
+/*
+ * Scheduling part of the upload, lives on a thread of its own together with OSVAPI.
+ * File reads, replies, JSON parsing and the progress journal never wait for the GUI thread, and
+ * the GUI thread only gets queued signals: the bytes and files uploaded are coalesced into
+ * UploadProgress snapshots published at a fixed cadence.
+ * The sequences are shared with the GUI thread, the engine changes them only under the mutex of
+ * the persistent controller and waits for the GUI thread only there, while it saves or counts
+ * them. The folders can not be added or removed while uploading.
+ * Everything is created by initialize() on the thread of the engine.
+ */
+class UploadEngine : public QObject
+{
+    Q_OBJECT
+public:
+    explicit UploadEngine(PersistentController* pc);
+
+public slots:
+    void initialize();
+    void start(const QString& token);
+    void pause();
+    void resume(const QString& token);
+    void reset();
+    void setMinConcurrency(const int minConcurrency);
+    void setMaxConcurrency(const int maxConcurrency);
+    void onInformationChanged();
+
+signals:
+    void progressChanged(const UploadProgress& progress);
+    void uploadStarted();
+    void uploadComplete();
+    void errorFound();
+    void concurrencyChanged(int minConcurrency, int maxConcurrency, int currentConcurrency);
+
+private slots:
+    void onUploadProgress(qint64 bytesDiff);
+    void onSequenceCreated(int sequenceIndex);
+    void onPhotoUploaded(int sequenceIndex, int photoIndex);
+    void onVideoUploaded(int sequenceIndex, int videoIndex);
+    void onSequenceFinished(int sequenceIndex);
+    void onErrorFound();
+    void onConcurrencyChanged();
+    void publishProgress();
+
+private:
+    void scheduleUploads();
+    int  nextSequenceToOpen() const;
+    void uploadSequence(PersistentSequence* sequence, const int sequenceIndex);
+    void requestNewSequence(PersistentSequence* sequence, const int sequenceIndex);
+    void dispatchFiles();
+    bool requestNextFile(const int sequenceIndex);
+    void finishSequenceIfSent(const int sequenceIndex);
+    void onFileUploaded(PersistentSequence* sequence, const int sequenceIndex, const int fileIndex);
+    void clearOpenSequences();
+    void setProgress(const qint64 uploadedSize, const int uploadedFiles);
+    bool isRunning() const;
+
+private:
+    PersistentController*  m_persistentController;
+    OSVAPI*                m_OSVAPI;
+    ConcurrencyController* m_concurrencyController;
+    QString                m_token;
+    bool                   m_isPaused;
+    bool                   m_isError;
+    bool                   m_isStarted;
+    bool                   m_isComplete;
+    int                    m_inFlightFiles;
+
+    // sequences being uploaded, in the order they were opened
+    QList<int> m_openSequences;
+    QSet<int>  m_creatingSequences;
+    QSet<int>  m_finishingSequences;
+    int        m_dispatchCursor;
+
+    RateEstimator  m_rateEstimator;
+    UploadProgress m_progress;
+    bool           m_isProgressPending;
+    QTimer*        m_progressTimer;
+};
+
+#endif  // UPLOADENGINE_H
@@ -0,0 +1,103 @@
+#include "uploadfiledevice.h"
+#include <QDebug>
+#include <QFileInfo>
+
+UploadFileDevice::UploadFileDevice(const QString& filePath, QObject* parent)
+    : QIODevice(parent)
+    , m_file(filePath)
+    , m_size(QFileInfo(filePath).size())
+{
+    // the device itself is opened right away (QHttpPart requires a readable body device),
+    // the file behind it is opened on the first read
+    QIODevice::open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+}
+
+UploadFileDevice::~UploadFileDevice()
+{
+    m_file.close();
+}
+
+bool UploadFileDevice::isSequential() const
+{
+    return false;
+}
+
+qint64 UploadFileDevice::size() const
+{
+    return m_size;
+}
+
+bool UploadFileDevice::seek(qint64 pos)
+{
+    if (!QIODevice::seek(pos))
+    {
+        return false;
+    }
+
+    // a closed file is positioned when it gets reopened
+    if (m_file.isOpen())
+    {
+        return m_file.seek(pos);
+    }
+    return true;
+}
+
+void UploadFileDevice::close()
+{
+    m_file.close();
+    QIODevice::close();
+}
+
+QString UploadFileDevice::fileName() const
+{
+    return m_file.fileName();
+}
+
+bool UploadFileDevice::hasContent() const
+{
+    return m_size > 0;
+}
+
+bool UploadFileDevice::openFile()
+{
+    if (m_file.isOpen())
+    {
+        return true;
+    }
+
+    if (!m_file.open(QIODevice::ReadOnly))
+    {
+        qDebug() << "Can not open upload file: " << m_file.fileName();
+        return false;
+    }
+    return m_file.seek(pos());
+}
+
+qint64 UploadFileDevice::readData(char* data, qint64 maxSize)
+{
+    if (pos() >= m_size)
+    {
+        m_file.close();
+        return 0;
+    }
+
+    if (!openFile())
+    {
+        return -1;
+    }
+
+    const qint64 bytesRead = m_file.read(data, qMin(maxSize, m_size - pos()));
+    if (bytesRead <= 0 || pos() + bytesRead >= m_size)
+    {
+        // whole body was handed to the network stack, release the file handle
+        m_file.close();
+    }
+    return bytesRead;
+}
+
+qint64 UploadFileDevice::writeData(const char* data, qint64 maxSize)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(maxSize);
+    return -1;
+}
@@ -0,0 +1,39 @@
+#ifndef UPLOADFILEDEVICE_H
+#define UPLOADFILEDEVICE_H
+
+#include <QFile>
+#include <QIODevice>
+
+/*
+ * Read-only device used as the body of a multipart upload.
+ * The underlying file is opened only when the network stack starts reading the body and is
+ * closed again once everything was read, so the content is streamed from disk in small chunks
+ * and requests waiting in the queue do not keep file handles open.
+ */
+class UploadFileDevice : public QIODevice
+{
+    Q_OBJECT
+public:
+    explicit UploadFileDevice(const QString& filePath, QObject* parent = 0);
+    ~UploadFileDevice();
+
+    bool isSequential() const;
+    qint64 size() const;
+    bool seek(qint64 pos);
+    void close();
+
+    QString fileName() const;
+    bool    hasContent() const;
+
+protected:
+    qint64 readData(char* data, qint64 maxSize);
+    qint64 writeData(const char* data, qint64 maxSize);
+
+private:
+    bool openFile();
+
+    QFile  m_file;
+    qint64 m_size;
+};
+
+#endif  // UPLOADFILEDEVICE_H
@@ -0,0 +1,12 @@
+TEMPLATE = subdirs
+SUBDIRS += \
+    exifbench \
+    exiffuzz \
+    gzipbench \
+    sequencebench \
+    shardbench \
+    stallbench \
+    trackbench \
+    uploadbench
+
+CONFIG += c++11
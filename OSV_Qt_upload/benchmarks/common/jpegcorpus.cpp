@@ -0,0 +1,307 @@
+#include "jpegcorpus.h"
+#include <cstring>
+#include <sstream>
+
+namespace
+{
+// small xorshift generator, the corpus has to be the same on every platform
+class Random
+{
+public:
+    explicit Random(unsigned seed)
+        : m_state(seed ? seed : 0x9E3779B9u)
+    {
+    }
+
+    unsigned next()
+    {
+        m_state ^= m_state << 13;
+        m_state ^= m_state >> 17;
+        m_state ^= m_state << 5;
+        return m_state;
+    }
+
+    unsigned next(unsigned bound)
+    {
+        return bound ? next() % bound : 0;
+    }
+
+private:
+    unsigned m_state;
+};
+
+/*
+ * TIFF writer honoring the byte order, offsets are relative to the TIFF header.
+ */
+class TiffWriter
+{
+public:
+    explicit TiffWriter(bool isIntel)
+        : m_isIntel(isIntel)
+    {
+    }
+
+    void put16(unsigned offset, unsigned value)
+    {
+        reserve(offset + 2);
+        m_data[offset + (m_isIntel ? 0 : 1)] = value & 0xFF;
+        m_data[offset + (m_isIntel ? 1 : 0)] = (value >> 8) & 0xFF;
+    }
+
+    void put32(unsigned offset, unsigned value)
+    {
+        reserve(offset + 4);
+        for (int byte = 0; byte < 4; ++byte)
+        {
+            m_data[offset + (m_isIntel ? byte : 3 - byte)] = (value >> (8 * byte)) & 0xFF;
+        }
+    }
+
+    void putBytes(unsigned offset, const char* bytes, unsigned length)
+    {
+        reserve(offset + length);
+        memcpy(&m_data[offset], bytes, length);
+    }
+
+    // IFD entry 'index' of the IFD at 'ifd', 'value' is the inline value or the data offset
+    void putEntry(unsigned ifd, unsigned index, unsigned tag, unsigned format, unsigned count,
+                  unsigned value)
+    {
+        const unsigned offset = ifd + 2 + 12 * index;
+        put16(offset, tag);
+        put16(offset + 2, format);
+        put32(offset + 4, count);
+        put32(offset + 8, value);
+    }
+
+    void putRational(unsigned offset, unsigned numerator, unsigned denominator)
+    {
+        put32(offset, numerator);
+        put32(offset + 4, denominator);
+    }
+
+    const JpegFile& data() const
+    {
+        return m_data;
+    }
+
+private:
+    void reserve(unsigned size)
+    {
+        if (m_data.size() < size)
+        {
+            m_data.resize(size, 0);
+        }
+    }
+
+    bool     m_isIntel;
+    JpegFile m_data;
+};
+
+void appendSegment(JpegFile& file, unsigned char marker, const JpegFile& payload)
+{
+    const unsigned length = payload.size() + 2;
+    file.push_back(0xFF);
+    file.push_back(marker);
+    file.push_back((length >> 8) & 0xFF);
+    file.push_back(length & 0xFF);
+    file.insert(file.end(), payload.begin(), payload.end());
+}
+
+JpegFile makeExifPayload(const JpegShape& shape, Random& random)
+{
+    TiffWriter tiff(shape.isIntel);
+    tiff.putBytes(0, shape.isIntel ? "II" : "MM", 2);
+    tiff.put16(2, 0x2A);
+    tiff.put32(4, 8);
+
+    // IFD0: Make, Model, EXIF sub-IFD and GPS IFD pointers
+    const unsigned ifd0    = 8;
+    const unsigned entries = shape.hasGps ? 4 : 3;
+    tiff.put16(ifd0, entries);
+    tiff.putEntry(ifd0, 0, 0x010F, 2, 4, 0);
+    tiff.putBytes(ifd0 + 2 + 8, "OSV", 4);
+    tiff.putEntry(ifd0, 1, 0x0110, 2, 12, 200);
+    tiff.putBytes(200, "Camera 2000", 12);
+    tiff.putEntry(ifd0, 2, 0x8769, 4, 1, 220);
+    if (shape.hasGps)
+    {
+        tiff.putEntry(ifd0, 3, 0x8825, 4, 1, 300);
+    }
+    tiff.put32(ifd0 + 2 + 12 * entries, 0);
+
+    // EXIF sub-IFD: DateTimeOriginal and exposure time
+    std::ostringstream dateTime;
+    dateTime << "2017:0" << 1 + random.next(9) << ":1" << random.next(10) << " 1"
+             << random.next(10) << ":2" << random.next(10) << ":3" << random.next(10);
+    tiff.put16(220, 2);
+    tiff.putEntry(220, 0, 0x9003, 2, 20, 260);
+    tiff.putBytes(260, dateTime.str().c_str(), 20);
+    tiff.putEntry(220, 1, 0x829A, 5, 1, 284);
+    tiff.putRational(284, 1, 100 + random.next(900));
+    tiff.put32(220 + 2 + 12 * 2, 0);
+
+    if (shape.hasGps)
+    {
+        // GPS IFD: references and degree/minute/second rationals
+        tiff.put16(300, 4);
+        tiff.putEntry(300, 0, 1, 2, 2, 0);
+        tiff.putBytes(300 + 2 + 8, random.next(2) ? "N" : "S", 2);
+        tiff.putEntry(300, 1, 2, 5, 3, 360);
+        tiff.putEntry(300, 2, 3, 2, 2, 0);
+        tiff.putBytes(300 + 2 + 24 + 8, random.next(2) ? "E" : "W", 2);
+        tiff.putEntry(300, 3, 4, 5, 3, 384);
+        tiff.put32(300 + 2 + 12 * 4, 0);
+        tiff.putRational(360, 1 + random.next(89), 1);
+        tiff.putRational(368, random.next(60), 1);
+        tiff.putRational(376, random.next(6000), 100);
+        tiff.putRational(384, 1 + random.next(179), 1);
+        tiff.putRational(392, random.next(60), 1);
+        tiff.putRational(400, random.next(6000), 100);
+    }
+
+    const char exifHeader[] = "Exif\0\0";
+    JpegFile   payload(6 + tiff.data().size());
+    memcpy(&payload[0], exifHeader, 6);
+    memcpy(&payload[6], tiff.data().data(), tiff.data().size());
+    return payload;
+}
+}
+
+JpegFile JpegCorpus::makeJpeg(const JpegShape& shape, unsigned seed)
+{
+    Random   random(seed);
+    JpegFile file;
+    file.push_back(0xFF);
+    file.push_back(0xD8);
+
+    const char jfif[] = "JFIF\0\1\1\0\0\1\0\1\0\0";
+    appendSegment(file, 0xE0, JpegFile(jfif, jfif + 14));
+
+    // ICC profiles are split in APP2 segments of at most 64 KB
+    for (unsigned padding = shape.appPadding; padding > 0;)
+    {
+        const unsigned length = padding < 65000 ? padding : 65000;
+        JpegFile       payload(length);
+        for (unsigned index = 0; index < length; ++index)
+        {
+            payload[index] = random.next() & 0xFF;
+        }
+        appendSegment(file, 0xE2, payload);
+        padding -= length;
+    }
+
+    if (shape.hasXmp)
+    {
+        const char xmp[] = "http://ns.adobe.com/xap/1.0/\0<x:xmpmeta/>";
+        appendSegment(file, 0xE1, JpegFile(xmp, xmp + sizeof(xmp) - 1));
+    }
+
+    appendSegment(file, 0xE1, makeExifPayload(shape, random));
+    appendSegment(file, 0xDB, JpegFile(65, 1));
+    appendSegment(file, 0xDA, JpegFile(10, 0));
+
+    for (unsigned index = 0; index < shape.imageSize; ++index)
+    {
+        const unsigned char byte = random.next() & 0xFF;
+        file.push_back(byte);
+        if (byte == 0xFF)
+        {
+            file.push_back(0x00);  // byte stuffing
+        }
+    }
+    file.push_back(0xFF);
+    file.push_back(0xD9);
+
+    if (shape.truncatedSize && shape.truncatedSize < file.size())
+    {
+        file.resize(shape.truncatedSize);
+    }
+    return file;
+}
+
+JpegShape JpegCorpus::shapeOf(unsigned index, unsigned seed)
+{
+    Random    random(seed + index * 7919);
+    JpegShape shape;
+    shape.isIntel       = index % 2 == 0;
+    shape.hasGps        = index % 8 != 2;
+    shape.hasXmp        = index % 8 == 4;
+    shape.appPadding    = index % 8 == 3 ? 200000 + random.next(200000) : 0;
+    shape.imageSize     = 100000 + random.next(400000);
+    shape.truncatedSize = 0;
+    if (index % 8 == 5)
+    {
+        shape.truncatedSize = 20 + random.next(400);  // cut inside the headers
+    }
+    else if (index % 8 == 6)
+    {
+        shape.truncatedSize = 1000 + random.next(shape.imageSize);  // cut inside the image data
+    }
+    return shape;
+}
+
+std::vector<JpegFile> JpegCorpus::makeCorpus(unsigned count, unsigned seed)
+{
+    std::vector<JpegFile> corpus;
+    corpus.reserve(count);
+    for (unsigned index = 0; index < count; ++index)
+    {
+        corpus.push_back(makeJpeg(shapeOf(index, seed), seed + index));
+    }
+    return corpus;
+}
+
+std::vector<JpegFile> JpegCorpus::makeHostileSegments()
+{
+    const char            exifHeader[] = "Exif\0\0";
+    const unsigned        tags[]       = {0x8825, 0x8769};
+    const unsigned        pointers[]   = {0xFFFFFFF6, 0xFFFFFFFA, 0xFFFFFFFF, 0x80000000, 24, 26};
+    std::vector<JpegFile> segments;
+    for (int isIntel = 0; isIntel < 2; ++isIntel)
+    {
+        for (unsigned tag : tags)
+        {
+            // IFD0 with a single sub-IFD pointer, 32 bytes with the "Exif" header
+            for (unsigned pointer : pointers)
+            {
+                TiffWriter tiff(isIntel);
+                tiff.putBytes(0, isIntel ? "II" : "MM", 2);
+                tiff.put16(2, 0x2A);
+                tiff.put32(4, 8);
+                tiff.put16(8, 1);
+                tiff.putEntry(8, 0, tag, 4, 1, pointer);
+                tiff.put32(8 + 2 + 12, 0);
+
+                JpegFile segment(exifHeader, exifHeader + 6);
+                segment.insert(segment.end(), tiff.data().begin(), tiff.data().end());
+                segments.push_back(segment);
+            }
+
+            // valid pointer to a sub-IFD claiming the maximum entry count
+            TiffWriter tiff(isIntel);
+            tiff.putBytes(0, isIntel ? "II" : "MM", 2);
+            tiff.put16(2, 0x2A);
+            tiff.put32(4, 8);
+            tiff.put16(8, 1);
+            tiff.putEntry(8, 0, tag, 4, 1, 26);
+            tiff.put32(8 + 2 + 12, 0);
+            tiff.put16(26, 0xFFFF);
+            tiff.put32(28, 0);
+
+            JpegFile segment(exifHeader, exifHeader + 6);
+            segment.insert(segment.end(), tiff.data().begin(), tiff.data().end());
+            segments.push_back(segment);
+        }
+    }
+    return segments;
+}
+
+std::string JpegCorpus::describe(const JpegShape& shape)
+{
+    std::ostringstream description;
+    description << (shape.isIntel ? "intel" : "motorola") << (shape.hasGps ? "" : "-nogps")
+                << (shape.hasXmp ? "-xmp" : "") << (shape.appPadding ? "-bigapp" : "")
+                << (shape.truncatedSize ? "-truncated" : "");
+    return description.str();
+}
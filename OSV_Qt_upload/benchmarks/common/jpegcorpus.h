@@ -0,0 +1,39 @@
+#ifndef JPEGCORPUS_H
+#define JPEGCORPUS_H
+
+#include <string>
+#include <vector>
+
+typedef std::vector<unsigned char> JpegFile;
+
+/*
+ * Shape of a generated JPEG, only the parts the EXIF parser looks at are realistic.
+ * The image data is random bytes with the 0xFF stuffing of real entropy coded data, so a byte
+ * scanner finds false markers in it.
+ */
+struct JpegShape
+{
+    bool     isIntel;        // byte order of the TIFF header
+    bool     hasGps;         // GPS IFD with a location
+    bool     hasXmp;         // XMP APP1 segment before the EXIF one
+    unsigned appPadding;     // bytes of APP2 (ICC profile) segments before the EXIF segment
+    unsigned imageSize;      // bytes of entropy coded data after SOS
+    unsigned truncatedSize;  // file cut to this many bytes, 0 keeps it whole
+};
+
+/*
+ * Deterministic corpus of photos as they come out of phones and cameras, plus broken ones.
+ */
+class JpegCorpus
+{
+public:
+    static JpegFile makeJpeg(const JpegShape& shape, unsigned seed);
+    // the shapes cycle through byte orders, missing GPS, huge APP segments and truncated files
+    static std::vector<JpegFile> makeCorpus(unsigned count, unsigned seed);
+    // EXIF segments with IFD pointers and entry counts that overflow 32-bit offset arithmetic
+    static std::vector<JpegFile> makeHostileSegments();
+    static std::string describe(const JpegShape& shape);
+    static JpegShape shapeOf(unsigned index, unsigned seed);
+};
+
+#endif  // JPEGCORPUS_H
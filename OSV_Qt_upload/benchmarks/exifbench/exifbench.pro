@@ -0,0 +1,16 @@
+TEMPLATE = app
+TARGET = exifbench
+
+CONFIG += console c++11
+CONFIG -= qt app_bundle
+
+# the parser is plain C++, it is built straight from the upload component
+INCLUDEPATH += $$PWD/../common $$PWD/../../UploadComponent
+
+SOURCES += main.cpp \
+    ../common/jpegcorpus.cpp \
+    ../../UploadComponent/exif.cpp
+
+HEADERS += \
+    ../common/jpegcorpus.h \
+    ../../UploadComponent/exif.h
@@ -0,0 +1,185 @@
+#include "exif.h"
+#include "jpegcorpus.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+/*
+ * Feeds readEXIFSegment() from memory the same way the photo scanner feeds it from a file.
+ */
+class MemoryStream : public easyexif::EXIFStream
+{
+public:
+    explicit MemoryStream(const JpegFile& file)
+        : m_file(file)
+        , m_offset(0)
+    {
+    }
+
+    unsigned read(unsigned char* buf, unsigned len)
+    {
+        const unsigned count = std::min<unsigned>(len, m_file.size() - m_offset);
+        memcpy(buf, m_file.data() + m_offset, count);
+        m_offset += count;
+        return count;
+    }
+
+    bool skip(unsigned len)
+    {
+        if (len > m_file.size() - m_offset)
+        {
+            return false;
+        }
+        m_offset += len;
+        return true;
+    }
+
+private:
+    const JpegFile& m_file;
+    unsigned        m_offset;
+};
+
+struct RunResult
+{
+    double   seconds;
+    unsigned located;  // photos with a location, has to match between the parsers
+};
+
+static RunResult runParseFrom(const std::vector<JpegFile>& corpus, unsigned iterations)
+{
+    RunResult  result = {0, 0};
+    const auto start  = std::chrono::steady_clock::now();
+    for (unsigned iteration = 0; iteration < iterations; ++iteration)
+    {
+        for (const JpegFile& file : corpus)
+        {
+            easyexif::EXIFInfo info;
+            if (info.parseFrom(file.data(), file.size()) == PARSE_EXIF_SUCCESS &&
+                info.GeoLocation.Latitude && info.GeoLocation.Longitude)
+            {
+                ++result.located;
+            }
+        }
+    }
+    result.seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+// the photo scanner path: segment walker, GPS fast path and optionally the capture time
+static RunResult runScanPath(const std::vector<JpegFile>& corpus, unsigned iterations,
+                             bool withDateTime)
+{
+    RunResult                  result = {0, 0};
+    std::vector<unsigned char> segment;
+    const auto                 start = std::chrono::steady_clock::now();
+    for (unsigned iteration = 0; iteration < iterations; ++iteration)
+    {
+        for (const JpegFile& file : corpus)
+        {
+            MemoryStream stream(file);
+            if (easyexif::EXIFInfo::readEXIFSegment(stream, segment) != PARSE_EXIF_SUCCESS)
+            {
+                continue;
+            }
+            easyexif::EXIFInfo::Geolocation_t geoLocation;
+            char                              dateTime[20];
+            easyexif::EXIFInfo::parseGeoLocationFromEXIFSegment(segment.data(), segment.size(),
+                                                                geoLocation);
+            if (withDateTime)
+            {
+                easyexif::EXIFInfo::parseDateTimeOriginalFromEXIFSegment(
+                    segment.data(), segment.size(), dateTime);
+            }
+            if (geoLocation.Latitude && geoLocation.Longitude)
+            {
+                ++result.located;
+            }
+        }
+    }
+    result.seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+static void report(const char* name, const RunResult& result, unsigned photos, double bytes)
+{
+    printf("%-12s %10.0f photos/s %10.1f MB/s %8u located\n", name, photos / result.seconds,
+           bytes / result.seconds / (1024 * 1024), result.located);
+}
+
+static bool writeFile(const char* path, const JpegFile& file)
+{
+    FILE* output = fopen(path, "wb");
+    if (!output || fwrite(file.data(), 1, file.size(), output) != file.size())
+    {
+        fprintf(stderr, "Can not write %s\n", path);
+        if (output)
+        {
+            fclose(output);
+        }
+        return false;
+    }
+    fclose(output);
+    return true;
+}
+
+static int writeCorpus(const char* directory, unsigned count)
+{
+    char path[1024];
+    for (unsigned index = 0; index < count; ++index)
+    {
+        const JpegShape shape = JpegCorpus::shapeOf(index, 1);
+        snprintf(path, sizeof(path), "%s/%04u-%s.jpg", directory, index,
+                 JpegCorpus::describe(shape).c_str());
+        if (!writeFile(path, JpegCorpus::makeJpeg(shape, 1 + index)))
+        {
+            return 1;
+        }
+    }
+
+    // bare EXIF segments, the fuzz target also feeds them to the segment parsers
+    const std::vector<JpegFile> segments = JpegCorpus::makeHostileSegments();
+    for (unsigned index = 0; index < segments.size(); ++index)
+    {
+        snprintf(path, sizeof(path), "%s/hostile-%02u.exif", directory, index);
+        if (!writeFile(path, segments[index]))
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Throughput of the EXIF parsing over a generated corpus.
+ *   exifbench [count] [iterations]
+ *   exifbench --write-corpus <directory> [count]   seeds the fuzzer and the replay harness
+ */
+int main(int argc, char* argv[])
+{
+    if (argc >= 3 && !strcmp(argv[1], "--write-corpus"))
+    {
+        return writeCorpus(argv[2], argc >= 4 ? atoi(argv[3]) : 64);
+    }
+
+    const unsigned count      = argc >= 2 ? atoi(argv[1]) : 400;
+    const unsigned iterations = argc >= 3 ? atoi(argv[2]) : 20;
+
+    const std::vector<JpegFile> corpus = JpegCorpus::makeCorpus(count, 1);
+    double                      bytes  = 0;
+    for (const JpegFile& file : corpus)
+    {
+        bytes += file.size();
+    }
+    printf("corpus: %u photos, %.1f MB, %u iterations\n", count, bytes / (1024 * 1024),
+           iterations);
+
+    const unsigned photos = count * iterations;
+    report("parseFrom", runParseFrom(corpus, iterations), photos, bytes * iterations);
+    report("gps path", runScanPath(corpus, iterations, false), photos, bytes * iterations);
+    report("scan path", runScanPath(corpus, iterations, true), photos, bytes * iterations);
+    return 0;
+}
@@ -0,0 +1,27 @@
+TEMPLATE = app
+TARGET = exiffuzz
+
+CONFIG += console c++11
+CONFIG -= qt app_bundle
+
+# qmake CONFIG+=fuzz builds a libFuzzer binary (clang), otherwise a replay harness is built that
+# runs the fuzz target over the given files or over the generated corpus. The replay harness is
+# only sanitized with CONFIG+=sanitize, not every toolchain ships ASan and UBSan.
+fuzz {
+    DEFINES += EXIF_FUZZ_LIBFUZZER
+    QMAKE_CXXFLAGS += -fsanitize=fuzzer,address,undefined
+    QMAKE_LFLAGS += -fsanitize=fuzzer,address,undefined
+} else:sanitize {
+    QMAKE_CXXFLAGS += -fsanitize=address,undefined
+    QMAKE_LFLAGS += -fsanitize=address,undefined
+}
+
+INCLUDEPATH += $$PWD/../common $$PWD/../../UploadComponent
+
+SOURCES += fuzz.cpp \
+    ../common/jpegcorpus.cpp \
+    ../../UploadComponent/exif.cpp
+
+HEADERS += \
+    ../common/jpegcorpus.h \
+    ../../UploadComponent/exif.h
@@ -0,0 +1,135 @@
+#include "exif.h"
+#include "jpegcorpus.h"
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+/*
+ * Fuzz target of the EXIF parser, every entry point gets the same input.
+ */
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+    easyexif::EXIFInfo info;
+    info.parseFrom(data, size);
+    info.parseFromEXIFSegment(data, size);
+
+    easyexif::EXIFInfo::Geolocation_t geoLocation;
+    char                              dateTime[20];
+    easyexif::EXIFInfo::parseGeoLocationFromEXIFSegment(data, size, geoLocation);
+    easyexif::EXIFInfo::parseDateTimeOriginalFromEXIFSegment(data, size, dateTime);
+    return 0;
+}
+
+#ifndef EXIF_FUZZ_LIBFUZZER
+
+static bool readFile(const char* path, std::vector<uint8_t>& data)
+{
+    FILE* input = fopen(path, "rb");
+    if (!input)
+    {
+        return false;
+    }
+    uint8_t buffer[65536];
+    size_t  count;
+    while ((count = fread(buffer, 1, sizeof(buffer), input)) > 0)
+    {
+        data.insert(data.end(), buffer, buffer + count);
+    }
+    fclose(input);
+    return true;
+}
+
+// writes 'size' bytes of 'value' at 'offset' in Intel or Motorola byte order
+static void putValue(JpegFile& file, size_t offset, unsigned size, uint32_t value, bool isIntel)
+{
+    for (unsigned byte = 0; byte < size; ++byte)
+    {
+        file[offset + (isIntel ? byte : size - 1 - byte)] = (value >> (8 * byte)) & 0xFF;
+    }
+}
+
+/*
+ * Replays the given files, or without arguments the hostile segments and the generated corpus
+ * with every truncation of its headers, single byte mutations of them, and IFD offset and entry
+ * count fields overwritten with values that wrap 32-bit offset arithmetic. Meant to run with the
+ * sanitizers on.
+ */
+int main(int argc, char* argv[])
+{
+    unsigned inputs = 0;
+    for (int arg = 1; arg < argc; ++arg)
+    {
+        std::vector<uint8_t> data;
+        if (!readFile(argv[arg], data))
+        {
+            fprintf(stderr, "Can not read %s\n", argv[arg]);
+            return 1;
+        }
+        LLVMFuzzerTestOneInput(data.data(), data.size());
+        ++inputs;
+    }
+
+    if (argc < 2)
+    {
+        for (const JpegFile& segment : JpegCorpus::makeHostileSegments())
+        {
+            LLVMFuzzerTestOneInput(segment.data(), segment.size());
+            ++inputs;
+        }
+
+        const std::vector<JpegFile> corpus = JpegCorpus::makeCorpus(16, 1);
+        for (const JpegFile& file : corpus)
+        {
+            // the headers of a file without big APP segments fit in the first KB
+            const size_t headerSize = file.size() < 1024 ? file.size() : 1024;
+            for (size_t size = 0; size <= headerSize; ++size)
+            {
+                LLVMFuzzerTestOneInput(file.data(), size);
+                ++inputs;
+            }
+
+            JpegFile mutated(file.begin(), file.begin() + headerSize);
+            for (size_t offset = 0; offset < headerSize; ++offset)
+            {
+                const uint8_t original = mutated[offset];
+                const uint8_t values[] = {0x00, 0xFF, (uint8_t)(original ^ 0x80)};
+                for (uint8_t value : values)
+                {
+                    mutated[offset] = value;
+                    LLVMFuzzerTestOneInput(mutated.data(), mutated.size());
+                    ++inputs;
+                }
+                mutated[offset] = original;
+            }
+
+            // every position may hold a 16-bit entry count or a 32-bit IFD offset
+            const uint32_t counts[]  = {0xFFFF, 0x8000, 0x1555};
+            const uint32_t offsets[] = {0xFFFFFFFF, 0xFFFFFFFA, 0xFFFFFFF6, 0x80000000,
+                                        0x7FFFFFFF, (uint32_t)headerSize};
+            for (size_t offset = 0; offset + 4 <= headerSize; ++offset)
+            {
+                for (int isIntel = 0; isIntel < 2; ++isIntel)
+                {
+                    for (uint32_t count : counts)
+                    {
+                        JpegFile field(mutated);
+                        putValue(field, offset, 2, count, isIntel);
+                        LLVMFuzzerTestOneInput(field.data(), field.size());
+                        ++inputs;
+                    }
+                    for (uint32_t value : offsets)
+                    {
+                        JpegFile field(mutated);
+                        putValue(field, offset, 4, value, isIntel);
+                        LLVMFuzzerTestOneInput(field.data(), field.size());
+                        ++inputs;
+                    }
+                }
+            }
+        }
+    }
+    printf("%u inputs replayed\n", inputs);
+    return 0;
+}
+
+#endif
@@ -0,0 +1,29 @@
+TEMPLATE = app
+TARGET = gzipbench
+
+QT += core concurrent
+QT -= gui
+
+CONFIG += console c++11
+CONFIG -= app_bundle
+
+# GZIP is built straight from the upload component
+INCLUDEPATH += $$PWD/../../UploadComponent
+
+SOURCES += main.cpp \
+    ../../UploadComponent/GZIP.cpp
+
+HEADERS += \
+    ../../UploadComponent/GZIP.h
+
+#zlib
+win32 {
+    LIBS+= $$OUT_PWD/../../zlib/release/zlib.lib
+}
+else:unix {
+    LIBS += -lz
+    LIBS+= $$OUT_PWD/../../zlib/libzlib.a
+}
+
+INCLUDEPATH += $$PWD/../../zlib
+DEPENDPATH += $$PWD/../../zlib
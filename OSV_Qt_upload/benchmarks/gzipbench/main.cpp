@@ -0,0 +1,166 @@
+#include "GZIP.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QTemporaryFile>
+#include <QTextStream>
+
+#define Z_PREFIX
+#include <zlib.h>
+#undef compress
+
+// the temporary file round trips GZIP used before compressing in memory
+static QByteArray tempFileDecompress(const QByteArray& data)
+{
+    QByteArray     ungzip;
+    QTemporaryFile temp;
+    if (!temp.open())
+    {
+        return QByteArray();
+    }
+    temp.write(data);
+    temp.close();
+    gzFile file = gzopen(temp.fileName().toLatin1(), "rb");
+    if (!file)
+    {
+        return QByteArray();
+    }
+    char buffer[10000];
+    int  r;
+    while ((r = gzread(file, buffer, 10000)) > 0)
+    {
+        ungzip.append(buffer, r);
+    }
+    gzclose(file);
+    return ungzip;
+}
+
+static QByteArray tempFileCompress(const QByteArray& ungzip)
+{
+    const QString tempPath = QDir::tempPath() + "/qt_temp.gz";
+    gzFile        file     = gzopen(tempPath.toLatin1(), "wb9");
+    if (!file)
+    {
+        return QByteArray();
+    }
+    gzwrite(file, ungzip.constData(), ungzip.size());
+    gzclose(file);
+    QFile finalFile(tempPath);
+    if (!finalFile.open(QIODevice::ReadOnly))
+    {
+        return QByteArray();
+    }
+    const QByteArray data = finalFile.readAll();
+    finalFile.remove();
+    return data;
+}
+
+// lines shaped like the ones of track.txt
+static QByteArray makeTrack(const int lines)
+{
+    QByteArray track("iPhone;10.2;1.4\n");
+    qsrand(1);
+    for (int line = 0; line < lines; ++line)
+    {
+        const double time = 1488000000.0 + line * 0.1;
+        track.append(QString("%1;%2;%3;%4;;;;;%5;%6;%7;;;;\n")
+                         .arg(time, 0, 'f', 3)
+                         .arg(46.77 + line * 1e-6, 0, 'f', 7)
+                         .arg(23.59 + (qrand() % 1000) * 1e-7, 0, 'f', 7)
+                         .arg(350 + qrand() % 20)
+                         .arg((qrand() % 2000) / 1000.0, 0, 'f', 3)
+                         .arg((qrand() % 2000) / 1000.0, 0, 'f', 3)
+                         .arg((qrand() % 2000) / 1000.0, 0, 'f', 3)
+                         .toLatin1());
+    }
+    return track;
+}
+
+static void report(QTextStream& out, const char* name, const qint64 bytes, const qint64 nsecs)
+{
+    out << QString(name).leftJustified(28) << QString::number(bytes * 1e3 / nsecs, 'f', 1)
+        << " MB/s\n";
+}
+
+/*
+ * GZIP in memory against the temporary file round trips it replaced.
+ *   gzipbench [lines]
+ */
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    const int        lines = argc >= 2 ? QString(argv[1]).toInt() : 200000;
+
+    const QByteArray track = makeTrack(lines);
+    QTextStream      out(stdout);
+    out << "track of " << track.size() / 1024 << " KB\n";
+
+    QElapsedTimer timer;
+    timer.start();
+    const QByteArray compressed = GZIP::compress(track);
+    report(out, "compress in memory", track.size(), timer.nsecsElapsed());
+
+    timer.restart();
+    const QByteArray tempCompressed = tempFileCompress(track);
+    report(out, "compress temporary file", track.size(), timer.nsecsElapsed());
+
+    timer.restart();
+    const QByteArray decompressed = GZIP::decompress(compressed, track.size());
+    report(out, "decompress in memory", track.size(), timer.nsecsElapsed());
+
+    timer.restart();
+    const QByteArray tempDecompressed = tempFileDecompress(tempCompressed);
+    report(out, "decompress temporary file", track.size(), timer.nsecsElapsed());
+
+    // fed as it would come from a file or the network, the output is dropped chunk by chunk
+    timer.restart();
+    GZIPInflater inflater;
+    QByteArray   chunk;
+    for (int offset = 0; offset < compressed.size(); offset += 65536)
+    {
+        chunk.clear();
+        inflater.write(compressed.constData() + offset, qMin(65536, compressed.size() - offset),
+                       chunk);
+    }
+    report(out, "decompress 64 KB chunks", track.size(), timer.nsecsElapsed());
+
+    if (decompressed != track || tempDecompressed != track || !inflater.isFinished())
+    {
+        qFatal("Round trip failed");
+    }
+
+    // whole files, as the tracks are compressed before upload
+    QTemporaryFile trackFile;
+    if (!trackFile.open() || trackFile.write(track) != track.size())
+    {
+        qFatal("Can not write the track");
+    }
+    trackFile.close();
+    const QString compressedPath = trackFile.fileName() + ".gz";
+    for (int level = 1; level <= 9; level += 4)
+    {
+        timer.restart();
+        GZIP::compress(trackFile.fileName(), compressedPath, level);
+        const qint64 serialTime = timer.nsecsElapsed();
+        const qint64 serialSize = QFileInfo(compressedPath).size();
+
+        timer.restart();
+        GZIP::compressParallel(trackFile.fileName(), compressedPath, level);
+        const qint64 parallelTime = timer.nsecsElapsed();
+        const qint64 parallelSize = QFileInfo(compressedPath).size();
+
+        QFile compressedFile(compressedPath);
+        if (!compressedFile.open(QIODevice::ReadOnly) ||
+            GZIP::decompress(compressedFile.readAll(), track.size()) != track)
+        {
+            qFatal("Parallel round trip failed");
+        }
+        compressedFile.close();
+
+        out << "file level " << level << ": serial "
+            << QString::number(track.size() * 1e3 / serialTime, 'f', 1) << " MB/s " << serialSize
+            << " B, parallel " << QString::number(track.size() * 1e3 / parallelTime, 'f', 1)
+            << " MB/s " << parallelSize << " B\n";
+    }
+    QFile::remove(compressedPath);
+    return 0;
+}
@@ -0,0 +1,107 @@
+#include "persistentsequence.h"
+#include "photo.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QTextStream>
+
+static PersistentSequence* makeSequence(const int count)
+{
+    PersistentSequence* sequence = new PersistentSequence();
+    QList<Photo*>       photos;
+    for (int index = 0; index < count; ++index)
+    {
+        PhotoInfo info;
+        info.path                = QString("/sequence/%1.jpg").arg(index);
+        info.size                = 1024 * 1024;
+        info.lat                 = 46.77;
+        info.lng                 = 23.59;
+        info.dateTimeOriginal[0] = 0;
+
+        Photo* photo = new Photo(sequence);
+        photo->setInfo(info);
+        photos.append(photo);
+    }
+    sequence->setPhotos(photos);
+    sequence->addPhotoInfo("/sequence", (qint64)count * 1024 * 1024);
+    return sequence;
+}
+
+// the lookup the pending queue replaced, a scan from the first file on every call
+static int linearScanNext(PersistentSequence* sequence)
+{
+    const QList<Photo*> photos = sequence->getPhotos();
+    for (int index = 0; index < photos.size(); ++index)
+    {
+        if (!sequence->isFileSent(index) && photos[index]->getStatus() == FileStatus::AVAILABLE)
+        {
+            return index;
+        }
+    }
+    return -1;
+}
+
+/*
+ * Takes every file of a sequence for upload and marks it sent, one file in 'releaseEvery' is
+ * handed back once first as if its request could not be started.
+ */
+static qint64 drain(const int count, const int releaseEvery, const bool useLinearScan)
+{
+    PersistentSequence* sequence = makeSequence(count);
+    const QList<Photo*> photos   = sequence->getPhotos();
+
+    QElapsedTimer timer;
+    timer.start();
+    int taken = 0;
+    while (true)
+    {
+        const int index = useLinearScan ? linearScanNext(sequence)
+                                        : sequence->getIndexOfNextAvailablePhoto();
+        if (index < 0)
+        {
+            break;
+        }
+        photos[index]->setStatus(FileStatus::BUSY);
+        if (releaseEvery && ++taken % releaseEvery == 0 && index % 2 == 0)
+        {
+            photos[index]->setStatus(FileStatus::AVAILABLE);
+            if (!useLinearScan)
+            {
+                sequence->releaseFile(index);
+            }
+            continue;
+        }
+        sequence->setFileSentOnIndex(index);
+        photos[index]->setStatus(FileStatus::DONE);
+    }
+    const qint64 elapsed = timer.nsecsElapsed();
+
+    if (!sequence->areAllFilesSent())
+    {
+        qFatal("Sequence not drained");
+    }
+    delete sequence;
+    return elapsed;
+}
+
+/*
+ * Cost of picking the next file of a sequence for upload.
+ *   sequencebench [files]
+ */
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    const int        count = argc >= 2 ? QString(argv[1]).toInt() : 20000;
+
+    QTextStream out(stdout);
+    out << "sequence of " << count << " photos\n";
+    const char* names[] = {"drain", "drain, 10% released"};
+    const int   releases[] = {0, 10};
+    for (int run = 0; run < 2; ++run)
+    {
+        const qint64 queue  = drain(count, releases[run], false);
+        const qint64 linear = drain(count, releases[run], true);
+        out << QString(names[run]).leftJustified(22) << "pending queue " << queue / count << " ns/file, linear scan "
+            << linear / count << " ns/file\n";
+    }
+    return 0;
+}
@@ -0,0 +1,41 @@
+TEMPLATE = app
+TARGET = sequencebench
+
+QT += core concurrent
+QT -= gui
+
+CONFIG += console c++11
+CONFIG -= app_bundle
+
+# the sequence model is built straight from the upload component
+INCLUDEPATH += $$PWD/../../UploadComponent
+
+SOURCES += main.cpp \
+    ../../UploadComponent/persistentsequence.cpp \
+    ../../UploadComponent/jsonserializable.cpp \
+    ../../UploadComponent/metadata.cpp \
+    ../../UploadComponent/GZIP.cpp \
+    ../../UploadComponent/photo.cpp \
+    ../../UploadComponent/video.cpp \
+    ../../UploadComponent/exif.cpp
+
+HEADERS += \
+    ../../UploadComponent/persistentsequence.h \
+    ../../UploadComponent/jsonserializable.h \
+    ../../UploadComponent/metadata.h \
+    ../../UploadComponent/GZIP.h \
+    ../../UploadComponent/photo.h \
+    ../../UploadComponent/video.h \
+    ../../UploadComponent/exif.h
+
+#zlib
+win32 {
+    LIBS+= $$OUT_PWD/../../zlib/release/zlib.lib
+}
+else:unix {
+    LIBS += -lz
+    LIBS+= $$OUT_PWD/../../zlib/libzlib.a
+}
+
+INCLUDEPATH += $$PWD/../../zlib
+DEPENDPATH += $$PWD/../../zlib
@@ -0,0 +1,225 @@
+#include "httprequest.h"
+#include "uploadtransport.h"
+#include <QAtomicInt>
+#include <QBuffer>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QHttpMultiPart>
+#include <QNetworkAccessManager>
+#include <QSemaphore>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTextStream>
+#include <QThread>
+#include <QTimer>
+#include <memory>
+
+static const int kRequests = 240;
+
+/*
+ * Loopback HTTP server on a thread of its own. Every upload is read whole and answered after
+ * 'latency' ms, as a distant server would. Counts the uploads it holds at once.
+ */
+class SinkServer : public QThread
+{
+public:
+    explicit SinkServer(const int latency)
+        : m_latency(latency)
+        , m_port(0)
+        , m_inFlight(0)
+        , m_peakInFlight(0)
+    {
+    }
+
+    quint16 startListening()
+    {
+        start();
+        m_ready.acquire();
+        return m_port;
+    }
+
+    int takePeakInFlight()
+    {
+        return m_peakInFlight.fetchAndStoreOrdered(0);
+    }
+
+protected:
+    void run()
+    {
+        QTcpServer server;
+        connect(&server, &QTcpServer::newConnection, [this, &server]() {
+            while (QTcpSocket* socket = server.nextPendingConnection())
+            {
+                accept(socket);
+            }
+        });
+        server.listen(QHostAddress::LocalHost);
+        m_port = server.serverPort();
+        m_ready.release();
+        exec();
+    }
+
+private:
+    struct Connection
+    {
+        QByteArray header;
+        qint64     remaining = -1;  // body bytes still to read, -1 while reading the header
+    };
+
+    void accept(QTcpSocket* socket)
+    {
+        std::shared_ptr<Connection> connection(new Connection());
+        connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+        connect(socket, &QTcpSocket::readyRead, [this, socket, connection]() {
+            while (socket->bytesAvailable())
+            {
+                if (connection->remaining < 0)
+                {
+                    connection->header += socket->readLine();
+                    if (!connection->header.endsWith("\r\n\r\n"))
+                    {
+                        continue;
+                    }
+                    connection->remaining = contentLength(connection->header);
+                    connection->header.clear();
+                    const int inFlight    = m_inFlight.fetchAndAddOrdered(1) + 1;
+                    int       peak        = m_peakInFlight.load();
+                    while (inFlight > peak && !m_peakInFlight.testAndSetOrdered(peak, inFlight))
+                    {
+                        peak = m_peakInFlight.load();
+                    }
+                }
+                connection->remaining -= socket->read(connection->remaining).size();
+                if (!connection->remaining)
+                {
+                    connection->remaining = -1;
+                    QTimer::singleShot(m_latency, socket, [this, socket]() {
+                        m_inFlight.deref();
+                        socket->write("HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n"
+                                      "Content-Length: 2\r\n\r\n{}");
+                    });
+                }
+            }
+        });
+    }
+
+    static qint64 contentLength(const QByteArray& header)
+    {
+        for (const QByteArray& line : header.split('\n'))
+        {
+            if (line.toLower().startsWith("content-length:"))
+            {
+                return line.mid(15).trimmed().toLongLong();
+            }
+        }
+        return 0;
+    }
+
+    const int  m_latency;
+    quint16    m_port;
+    QSemaphore m_ready;
+    QAtomicInt m_inFlight;
+    QAtomicInt m_peakInFlight;
+};
+
+static QHttpMultiPart* makeBody(const QByteArray& content)
+{
+    QHttpMultiPart* multipart = new QHttpMultiPart(QHttpMultiPart::FormDataType);
+    QBuffer*        buffer    = new QBuffer(multipart);
+    buffer->setData(content);
+    buffer->open(QIODevice::ReadOnly);
+
+    QHttpPart filePart;
+    filePart.setHeader(QNetworkRequest::ContentTypeHeader, QVariant("image/jpeg"));
+    filePart.setHeader(QNetworkRequest::ContentDispositionHeader,
+                       QVariant("form-data; name=\"photo\"; filename=\"shard.jpg\""));
+    filePart.setBodyDevice(buffer);
+    multipart->append(filePart);
+    return multipart;
+}
+
+/*
+ * Uploads kRequests bodies keeping 'concurrency' of them in flight, through the transport or
+ * through a single manager on this thread if 'transport' is null. Returns the elapsed ms.
+ */
+static qint64 upload(const QString& url, const QByteArray& content, const int concurrency,
+                     UploadTransport* transport, QNetworkAccessManager* manager)
+{
+    QEventLoop            loop;
+    int                   started  = 0;
+    int                   finished = 0;
+    std::function<void()> startNext;
+    startNext = [&]() {
+        HTTPRequest* request = transport ? new HTTPRequest(nullptr, transport)
+                                         : new HTTPRequest(nullptr, manager);
+        request->setHandlerFunc([&, request](const HTTPResponse& response) {
+            if (response.error != QNetworkReply::NoError)
+            {
+                qFatal("Upload failed: %s", qPrintable(response.errorString));
+            }
+            if (started < kRequests)
+            {
+                ++started;
+                startNext();
+            }
+            if (++finished == kRequests)
+            {
+                loop.quit();
+            }
+            delete request;
+        });
+        request->post(url, makeBody(content));
+    };
+
+    QElapsedTimer timer;
+    timer.start();
+    for (; started < qMin(concurrency, kRequests); ++started)
+    {
+        startNext();
+    }
+    loop.exec();
+    return timer.elapsed();
+}
+
+/*
+ * Upload throughput over loopback with a single network access manager and with the uploads
+ * spread on shards, for a growing number of uploads in flight.
+ *   shardbench [body KB] [server latency ms]
+ */
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    const int        bodySize = (argc >= 2 ? QString(argv[1]).toInt() : 256) * 1024;
+    const int        latency  = argc >= 3 ? QString(argv[2]).toInt() : 50;
+
+    SinkServer    server(latency);
+    const QString url = QString("http://127.0.0.1:%1/upload").arg(server.startListening());
+
+    QTextStream out(stdout);
+    out << kRequests << " uploads of " << bodySize / 1024 << " KB, server latency " << latency
+        << " ms\n";
+
+    const QByteArray      content(bodySize, 'x');
+    QNetworkAccessManager manager;
+    const int             shardCounts[]  = {0, 1, 2, 4};
+    const int             concurrences[] = {6, 12, 24};
+    for (const int shards : shardCounts)
+    {
+        QScopedPointer<UploadTransport> transport(shards ? new UploadTransport(shards) : nullptr);
+        for (const int concurrency : concurrences)
+        {
+            const qint64 elapsed = qMax<qint64>(1, upload(url, content, concurrency, transport.data(),
+                                                           &manager));
+            const QString name = shards ? QString("%1 shards").arg(shards) : QString("one manager");
+            out << name.leftJustified(12) << QString("%1 in flight").arg(concurrency).leftJustified(14)
+                << QString::number((double)kRequests * bodySize / 1024 / 1024 * 1000 / elapsed, 'f', 1)
+                << " MB/s, server held " << server.takePeakInFlight() << " at once\n";
+            out.flush();
+        }
+    }
+
+    server.quit();
+    server.wait();
+    return 0;
+}
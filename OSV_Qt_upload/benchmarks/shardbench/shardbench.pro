@@ -0,0 +1,21 @@
+TEMPLATE = app
+TARGET = shardbench
+
+QT += core network
+QT -= gui
+
+CONFIG += console c++11
+CONFIG -= app_bundle
+
+# the transport is built straight from the HTTPRequest library
+DEFINES += HTTPREQUEST_LIBRARY
+INCLUDEPATH += $$PWD/../../HTTPRequest
+
+SOURCES += main.cpp \
+    ../../HTTPRequest/httprequest.cpp \
+    ../../HTTPRequest/uploadtransport.cpp
+
+HEADERS += \
+    ../../HTTPRequest/httprequest.h \
+    ../../HTTPRequest/httprequest_global.h \
+    ../../HTTPRequest/uploadtransport.h
@@ -0,0 +1,227 @@
+#include "httprequest.h"
+#include <QBuffer>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QHttpMultiPart>
+#include <QNetworkAccessManager>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTextStream>
+#include <QTimer>
+#include <memory>
+
+static const int    kRequests       = 6;
+static const int    kQueuedRequests = 12;
+static const int    kTrickleBytes   = 1024;
+static const int    kSteadyBytes    = 256 * 1024;
+static const int    kTrickleTick    = 100;
+static const qint64 kWatchdogSlack  = 1000;
+
+enum class ServerMode
+{
+    STALLED,   // reads nothing
+    TRICKLE,   // reads kTrickleBytes per tick
+    STEADY     // reads kSteadyBytes per tick and answers every whole body
+};
+
+static qint64 contentLength(const QByteArray& header)
+{
+    for (const QByteArray& line : header.split('\n'))
+    {
+        if (line.toLower().startsWith("content-length:"))
+        {
+            return line.mid(15).trimmed().toLongLong();
+        }
+    }
+    return 0;
+}
+
+/*
+ * Local server that takes the connections of the uploads and then reads nothing, so their bodies
+ * stall once the socket buffers are full. In trickle mode it reads a little on every tick, the
+ * uploads go on but too slowly to make the deadline. In steady mode it reads at a fixed rate and
+ * answers, so the uploads beyond the six connections of the manager wait in its queue.
+ */
+static void startServer(QTcpServer& server, const ServerMode mode)
+{
+    QObject::connect(&server, &QTcpServer::newConnection, [&server, mode]() {
+        while (QTcpSocket* socket = server.nextPendingConnection())
+        {
+            if (mode == ServerMode::STALLED)
+            {
+                socket->setReadBufferSize(1);
+                continue;
+            }
+
+            socket->setReadBufferSize(mode == ServerMode::TRICKLE ? kTrickleBytes : kSteadyBytes);
+            std::shared_ptr<QByteArray> header(new QByteArray());
+            std::shared_ptr<qint64>     remaining(new qint64(-1));
+            QTimer*                     timer = new QTimer(socket);
+            QObject::connect(timer, &QTimer::timeout, [socket, mode, header, remaining]() {
+                if (mode == ServerMode::TRICKLE)
+                {
+                    socket->readAll();
+                    return;
+                }
+                // one tick reads at most the read buffer, the rate stays fixed
+                while (socket->bytesAvailable())
+                {
+                    if (*remaining < 0)
+                    {
+                        *header += socket->readLine();
+                        if (!header->endsWith("\r\n\r\n"))
+                        {
+                            continue;
+                        }
+                        *remaining = contentLength(*header);
+                        header->clear();
+                    }
+                    *remaining -= socket->read(*remaining).size();
+                    if (!*remaining)
+                    {
+                        *remaining = -1;
+                        socket->write("HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n"
+                                      "Content-Length: 2\r\n\r\n{}");
+                    }
+                }
+            });
+            timer->start(kTrickleTick);
+        }
+    });
+    server.listen(QHostAddress::LocalHost);
+}
+
+static QHttpMultiPart* makeBody(const QByteArray& content)
+{
+    QHttpMultiPart* multipart = new QHttpMultiPart(QHttpMultiPart::FormDataType);
+    QBuffer*        buffer    = new QBuffer(multipart);
+    buffer->setData(content);
+    buffer->open(QIODevice::ReadOnly);
+
+    QHttpPart filePart;
+    filePart.setHeader(QNetworkRequest::ContentTypeHeader, QVariant("image/jpeg"));
+    filePart.setHeader(QNetworkRequest::ContentDispositionHeader,
+                       QVariant("form-data; name=\"photo\"; filename=\"stall.jpg\""));
+    filePart.setBodyDevice(buffer);
+    multipart->append(filePart);
+    return multipart;
+}
+
+/*
+ * Uploads twice as many bodies as the manager has connections to a server that reads them at a
+ * steady rate, the second half waits in the queue of the manager for longer than the stall timeout.
+ * None of them may be aborted: the stall clock starts with the first bytes sent.
+ */
+static int runQueued(QCoreApplication& app, const int stallTimeout, const int bodySize)
+{
+    QTcpServer server;
+    startServer(server, ServerMode::STEADY);
+    const QString url = QString("http://127.0.0.1:%1/upload").arg(server.serverPort());
+
+    QTextStream out(stdout);
+    out << "steady server, " << kQueuedRequests << " uploads of " << bodySize / (1024 * 1024)
+        << " MB on one manager, stall timeout " << stallTimeout << " ms\n";
+    out.flush();
+
+    QNetworkAccessManager manager;
+    const QByteArray      content(bodySize, 'x');
+    QElapsedTimer         timer;
+    int                   finished = 0;
+    int                   failed   = 0;
+    timer.start();
+    for (int index = 0; index < kQueuedRequests; ++index)
+    {
+        HTTPRequest* request = new HTTPRequest(nullptr, &manager);
+        request->setTimeouts(stallTimeout, 0, 0);
+        request->setHandlerFunc([&, request, index](const HTTPResponse& response) {
+            out << "upload " << index << ": error " << (int)response.error << " after "
+                << timer.elapsed() << " ms, timed out " << request->isTimedOut() << "\n";
+            out.flush();
+            failed += response.error != QNetworkReply::NoError;
+            if (++finished == kQueuedRequests)
+            {
+                app.quit();
+            }
+            delete request;
+        });
+        request->post(url, makeBody(content));
+    }
+    app.exec();
+
+    const bool hasWaited = timer.elapsed() > 2 * stallTimeout;
+    out << failed << " of " << kQueuedRequests << " failed in " << timer.elapsed() << " ms"
+        << (hasWaited ? "" : ", the queue did not wait past the stall timeout, use bigger bodies")
+        << "\n";
+    return failed ? 1 : 0;
+}
+
+/*
+ * Time for the HTTPRequest watchdog to give back the upload slots held by a server that stopped
+ * reading, or that reads too slowly for the deadline. --queued checks that uploads waiting for a
+ * connection are not taken as stalled.
+ *   stallbench [stall timeout ms] [body MB]
+ *   stallbench --trickle [deadline ms] [body MB]
+ *   stallbench --queued [stall timeout ms] [body MB]
+ */
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QStringList      arguments = app.arguments().mid(1);
+    const bool       trickle   = arguments.removeAll("--trickle") > 0;
+    const bool       queued    = arguments.removeAll("--queued") > 0;
+    const int        timeout   = arguments.size() > 0 ? arguments[0].toInt() : trickle ? 5000 : queued ? 1500 : 3000;
+    const int        bodySize  = (arguments.size() > 1 ? arguments[1].toInt() : trickle || queued ? 8 : 64) * 1024 * 1024;
+    if (queued)
+    {
+        return runQueued(app, timeout, bodySize);
+    }
+
+    // a trickle keeps the bodies moving, only the deadline can end them
+    const int    stallTimeout = trickle ? 0 : timeout;
+    const int    deadline     = trickle ? timeout : 0;
+    const qint64 minimumRate  = trickle ? 1024 * 1024 : 0;
+    const qint64 window       = trickle ? deadline + (qint64)bodySize * 1000 / minimumRate : stallTimeout;
+
+    QTcpServer server;
+    startServer(server, trickle ? ServerMode::TRICKLE : ServerMode::STALLED);
+    const QString url = QString("http://127.0.0.1:%1/upload").arg(server.serverPort());
+
+    QTextStream out(stdout);
+    out << (trickle ? "trickling" : "stalled") << " server, " << kRequests << " uploads of "
+        << bodySize / (1024 * 1024) << " MB, watchdog window " << window << " ms\n";
+    out.flush();
+
+    QNetworkAccessManager manager;
+    const QByteArray      content(bodySize, 'x');
+    QElapsedTimer         timer;
+    int                   finished  = 0;
+    int                   timedOut  = 0;
+    qint64                recovered = 0;
+    timer.start();
+    for (int index = 0; index < kRequests; ++index)
+    {
+        HTTPRequest* request = new HTTPRequest(nullptr, &manager);
+        request->setTimeouts(stallTimeout, deadline, minimumRate);
+        request->setHandlerFunc([&, request, index](const HTTPResponse& response) {
+            const qint64 elapsed = timer.elapsed();
+            out << "upload " << index << ": error " << (int)response.error << " after " << elapsed
+                << " ms, timed out " << request->isTimedOut() << "\n";
+            out.flush();
+            timedOut += request->isTimedOut();
+            recovered = qMax(recovered, elapsed);
+            if (++finished == kRequests)
+            {
+                app.quit();
+            }
+            // deleted right away as the upload handlers do
+            delete request;
+        });
+        request->post(url, makeBody(content));
+    }
+    app.exec();
+
+    const bool isRecovered = timedOut == kRequests && recovered <= window + kWatchdogSlack;
+    out << "slots recovered after " << recovered << " ms, " << timedOut << " of " << kRequests
+        << " timed out, " << (isRecovered ? "within" : "OUTSIDE") << " the window\n";
+    return isRecovered ? 0 : 1;
+}
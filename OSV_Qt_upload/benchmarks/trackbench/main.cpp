@@ -0,0 +1,137 @@
+#include "metadata.h"
+#include "trackstore.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+// lines shaped like the ones of a 1.0.8 track.txt, every column filled
+static std::string makeTrack(const int lines)
+{
+    std::string track("iPhone;10.2;" kVersion108 "\n");
+    char        line[256];
+    srand(1);
+    for (int index = 0; index < lines; ++index)
+    {
+        snprintf(line, sizeof(line),
+                 "%.3f;%.7f;%.7f;%.1f;%d;%.2f;%.4f;%.4f;%.4f;%.4f;%.4f;%.4f;%.2f;%.1f;%d;%.4f;"
+                 "%.4f;%.4f;%d\n",
+                 1488000000.0 + index * 0.1, 23.59 + (rand() % 1000) * 1e-7,
+                 46.77 + index * 1e-6, 350 + (rand() % 200) / 10.0, 5 + rand() % 10,
+                 (rand() % 3000) / 100.0, (rand() % 628) / 100.0, (rand() % 314) / 100.0,
+                 (rand() % 314) / 100.0, (rand() % 2000) / 1000.0, (rand() % 2000) / 1000.0,
+                 (rand() % 2000) / 1000.0, 1013 + (rand() % 100) / 100.0,
+                 (rand() % 3600) / 10.0, index / 10, (rand() % 2000) / 1000.0,
+                 (rand() % 2000) / 1000.0, 9.81 - (rand() % 100) / 1000.0, rand() % 120);
+        track.append(line);
+    }
+    return track;
+}
+
+// best time of 'iterations' runs of 'run', in seconds
+template <typename Run>
+static double bestOf(const int iterations, Run run)
+{
+    double best = 0;
+    for (int iteration = 0; iteration < iterations; ++iteration)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        run();
+        const double seconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (!best || seconds < best)
+        {
+            best = seconds;
+        }
+    }
+    return best;
+}
+
+static bool isSameRow(const MetaDataInfo& first, const MetaDataInfo& second)
+{
+    return !memcmp(&first._timestamp, &second._timestamp,
+                   (const char*)&first._OBD2speed - (const char*)&first._timestamp +
+                       sizeof(double)) &&
+           first._isInterpolated == second._isInterpolated;
+}
+
+/*
+ * Parsing speed of track files by Metadata::parseMetaData and TrackStore, the TrackStore cache
+ * and its lookups.
+ *   trackbench [lines] [iterations] [cache path]
+ */
+int main(int argc, char* argv[])
+{
+    const int         lines      = argc >= 2 ? atoi(argv[1]) : 2000000;
+    const int         iterations = argc >= 3 ? atoi(argv[2]) : 3;
+    const std::string cachePath  = argc >= 4 ? argv[3] : "trackbench.cache";
+    const int         lookups    = 1000000;
+
+    const std::string track = makeTrack(lines);
+    const double      size  = track.size() / (1024.0 * 1024);
+    printf("track of %d lines, %.1f MB\n", lines, size);
+
+    Metadata metadata;
+    double   seconds = bestOf(iterations, [&]() {
+        metadata = Metadata();
+        Metadata::parseMetaData(track, metadata);
+    });
+    printf("Metadata::parseMetaData   %10.0f lines/s %8.1f MB/s\n", lines / seconds, size / seconds);
+
+    TrackStore store;
+    seconds = bestOf(iterations, [&]() { TrackStore::parseMetaData(track, store); });
+    printf("TrackStore::parseMetaData %10.0f lines/s %8.1f MB/s\n", lines / seconds, size / seconds);
+
+    // Metadata parses the ending new line as one more, empty row, the store does not
+    if (metadata.metadataInfo.size() != (size_t)lines + 1 || store.size() != (size_t)lines)
+    {
+        fprintf(stderr, "Track not parsed\n");
+        return 1;
+    }
+    for (int index = 0; index < lines; ++index)
+    {
+        if (!isSameRow(metadata.metadataInfo[index], store.row(index)))
+        {
+            fprintf(stderr, "Row %d of the track store differs\n", index);
+            return 1;
+        }
+    }
+
+    if (!store.save(cachePath, track.size()))
+    {
+        fprintf(stderr, "Can not save %s\n", cachePath.c_str());
+        return 1;
+    }
+    TrackStore cached;
+    seconds = bestOf(iterations, [&]() { cached.load(cachePath, track.size()); });
+    remove(cachePath.c_str());
+    if (cached.size() != store.size() || !isSameRow(cached.row(lines - 1), store.row(lines - 1)))
+    {
+        fprintf(stderr, "Track cache not loaded\n");
+        return 1;
+    }
+    printf("TrackStore::load          %10.0f lines/s %8.1f MB/s of text\n", lines / seconds,
+           size / seconds);
+
+    const double* timestamps = store.column(&MetaDataInfo::_timestamp);
+    size_t        checksum   = 0;
+    srand(2);
+    seconds = bestOf(iterations, [&]() {
+        for (int lookup = 0; lookup < lookups; ++lookup)
+        {
+            checksum += store.nearestRow(timestamps[0] + (rand() % lines) * 0.1 + 0.04);
+        }
+    });
+    printf("TrackStore::nearestRow    %10.1f ns/lookup\n", seconds * 1e9 / lookups);
+
+    double lat = 0, lng = 0;
+    seconds = bestOf(iterations, [&]() {
+        for (int lookup = 0; lookup < lookups; ++lookup)
+        {
+            checksum += store.positionForIndex(rand() % (lines / 10), lat, lng);
+        }
+    });
+    printf("TrackStore::positionForIndex %7.1f ns/lookup\n", seconds * 1e9 / lookups);
+    return checksum ? 0 : 1;
+}
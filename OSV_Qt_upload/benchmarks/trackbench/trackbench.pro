@@ -0,0 +1,23 @@
+TEMPLATE = app
+TARGET = trackbench
+
+QT += core
+QT -= gui
+
+CONFIG += console c++11
+CONFIG -= app_bundle
+
+# the track parsing is built straight from OSVAPI
+INCLUDEPATH += $$PWD/../../OSVAPI
+
+SOURCES += main.cpp \
+    ../../OSVAPI/metadata.cpp \
+    ../../OSVAPI/metadatainfo.cpp \
+    ../../OSVAPI/trackstore.cpp \
+    ../../OSVAPI/utils.cpp
+
+HEADERS += \
+    ../../OSVAPI/metadata.h \
+    ../../OSVAPI/metadatainfo.h \
+    ../../OSVAPI/trackstore.h \
+    ../../OSVAPI/utils.h
@@ -0,0 +1,257 @@
+#include "uploadfiledevice.h"
+#include <QBuffer>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QHttpMultiPart>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QSemaphore>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QThread>
+#include <memory>
+#ifdef Q_OS_WIN
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+// growth of the peak RSS allowed while streaming, independent of the file sizes
+static const qint64 kStreamedBound = 64 * 1024 * 1024;
+
+/*
+ * Loopback HTTP server on a thread of its own. Every upload is read and dropped in small chunks
+ * and answered once its body is complete, so the server adds nothing that grows with the files.
+ */
+class SinkServer : public QThread
+{
+public:
+    SinkServer()
+        : m_port(0)
+    {
+    }
+
+    quint16 startListening()
+    {
+        start();
+        m_ready.acquire();
+        return m_port;
+    }
+
+protected:
+    void run()
+    {
+        QTcpServer server;
+        connect(&server, &QTcpServer::newConnection, [this, &server]() {
+            while (QTcpSocket* socket = server.nextPendingConnection())
+            {
+                accept(socket);
+            }
+        });
+        server.listen(QHostAddress::LocalHost);
+        m_port = server.serverPort();
+        m_ready.release();
+        exec();
+    }
+
+private:
+    struct Connection
+    {
+        QByteArray header;
+        qint64     remaining = -1;  // body bytes still to read, -1 while reading the header
+    };
+
+    void accept(QTcpSocket* socket)
+    {
+        std::shared_ptr<Connection> connection(new Connection());
+        socket->setReadBufferSize(64 * 1024);
+        connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+        connect(socket, &QTcpSocket::readyRead, [socket, connection]() {
+            while (socket->bytesAvailable())
+            {
+                if (connection->remaining < 0)
+                {
+                    connection->header += socket->readLine();
+                    if (!connection->header.endsWith("\r\n\r\n"))
+                    {
+                        continue;
+                    }
+                    connection->remaining = contentLength(connection->header);
+                    connection->header.clear();
+                }
+                connection->remaining -=
+                    socket->read(qMin<qint64>(connection->remaining, 64 * 1024)).size();
+                if (!connection->remaining)
+                {
+                    connection->remaining = -1;
+                    socket->write("HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n"
+                                  "Content-Length: 2\r\n\r\n{}");
+                }
+            }
+        });
+    }
+
+    static qint64 contentLength(const QByteArray& header)
+    {
+        for (const QByteArray& line : header.split('\n'))
+        {
+            if (line.toLower().startsWith("content-length:"))
+            {
+                return line.mid(15).trimmed().toLongLong();
+            }
+        }
+        return 0;
+    }
+
+    quint16    m_port;
+    QSemaphore m_ready;
+};
+
+// peak resident set size of the process in bytes
+static qint64 peakRss()
+{
+#ifdef Q_OS_WIN
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    {
+        return 0;
+    }
+    return counters.PeakWorkingSetSize;
+#else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef Q_OS_MAC
+    return usage.ru_maxrss;
+#else
+    return (qint64)usage.ru_maxrss * 1024;
+#endif
+#endif
+}
+
+static bool writeFile(const QString& path, const qint64 size)
+{
+    QFile            file(path);
+    const QByteArray chunk(1024 * 1024, 'x');
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        return false;
+    }
+    for (qint64 written = 0; written < size; written += chunk.size())
+    {
+        if (file.write(chunk.constData(), qMin<qint64>(chunk.size(), size - written)) < 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * Multipart as OSVAPI builds it for a photo. 'buffered' reads the whole file into memory first,
+ * as the uploads did before UploadFileDevice.
+ */
+static QHttpMultiPart* makeBody(const QString& path, const bool buffered)
+{
+    QHttpMultiPart* multipart = new QHttpMultiPart(QHttpMultiPart::FormDataType);
+    QIODevice*      body;
+    if (buffered)
+    {
+        QFile file(path);
+        file.open(QIODevice::ReadOnly);
+        QBuffer* buffer = new QBuffer(multipart);
+        buffer->setData(file.readAll());
+        buffer->open(QIODevice::ReadOnly);
+        body = buffer;
+    }
+    else
+    {
+        body = new UploadFileDevice(path, multipart);
+    }
+
+    QHttpPart filePart;
+    filePart.setHeader(QNetworkRequest::ContentTypeHeader, QVariant("image/jpeg"));
+    filePart.setHeader(QNetworkRequest::ContentDispositionHeader,
+                       QVariant("form-data; name=\"photo\"; filename=\"upload.jpg\""));
+    filePart.setBodyDevice(body);
+    multipart->append(filePart);
+    return multipart;
+}
+
+/*
+ * Peak RSS while uploading large files to a loopback server, all of them posted at once as the
+ * upload engine does when it fills its slots. Peak RSS only grows, so each mode runs in a process
+ * of its own. Streaming fails the run if the peak grows by more than kStreamedBound.
+ *   uploadbench [files] [file MB]
+ *   uploadbench --buffered [files] [file MB]
+ */
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QStringList      arguments = app.arguments().mid(1);
+    const bool       buffered  = arguments.removeAll("--buffered") > 0;
+    const int        count     = arguments.size() > 0 ? arguments[0].toInt() : 8;
+    const qint64     fileSize  = (arguments.size() > 1 ? arguments[1].toLongLong() : 128) * 1024 * 1024;
+
+    QTextStream   out(stdout);
+    QTemporaryDir directory;
+    QStringList   paths;
+    for (int index = 0; index < count; ++index)
+    {
+        paths.append(directory.path() + QString("/%1.jpg").arg(index));
+        if (!writeFile(paths.last(), fileSize))
+        {
+            out << "Can not write " << paths.last() << "\n";
+            return 1;
+        }
+    }
+
+    SinkServer    server;
+    const QUrl    url(QString("http://127.0.0.1:%1/upload").arg(server.startListening()));
+    const qint64  baseline = peakRss();
+    out << count << " uploads of " << fileSize / (1024 * 1024) << " MB, "
+        << (buffered ? "buffered" : "streamed") << ", peak RSS before " << baseline / (1024 * 1024)
+        << " MB\n";
+    out.flush();
+
+    QNetworkAccessManager manager;
+    QEventLoop            loop;
+    QElapsedTimer         timer;
+    int                   finished = 0;
+    int                   failed   = 0;
+    timer.start();
+    for (const QString& path : paths)
+    {
+        QHttpMultiPart* multipart = makeBody(path, buffered);
+        QNetworkReply*  reply     = manager.post(QNetworkRequest(url), multipart);
+        multipart->setParent(reply);
+        QObject::connect(reply, &QNetworkReply::finished, [&, reply]() {
+            failed += reply->error() != QNetworkReply::NoError;
+            if (++finished == paths.size())
+            {
+                loop.quit();
+            }
+            reply->deleteLater();
+        });
+    }
+    loop.exec();
+    const qint64 elapsed = qMax<qint64>(1, timer.elapsed());
+
+    server.quit();
+    server.wait();
+
+    const qint64 growth = peakRss() - baseline;
+    out << failed << " failed, "
+        << QString::number((double)count * fileSize / (1024 * 1024) * 1000 / elapsed, 'f', 1)
+        << " MB/s, peak RSS grew by " << growth / (1024 * 1024) << " MB\n";
+    if (!buffered && growth > kStreamedBound)
+    {
+        out << "peak RSS grew by more than " << kStreamedBound / (1024 * 1024) << " MB\n";
+        return 1;
+    }
+    return failed ? 1 : 0;
+}
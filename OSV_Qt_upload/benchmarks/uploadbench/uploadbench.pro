@@ -0,0 +1,21 @@
+TEMPLATE = app
+TARGET = uploadbench
+
+QT += core network
+QT -= gui
+
+CONFIG += console c++11
+CONFIG -= app_bundle
+
+# the upload body device is built straight from the upload component
+INCLUDEPATH += $$PWD/../../UploadComponent
+
+SOURCES += main.cpp \
+    ../../UploadComponent/uploadfiledevice.cpp
+
+HEADERS += \
+    ../../UploadComponent/uploadfiledevice.h
+
+win32 {
+    LIBS += -lpsapi
+}